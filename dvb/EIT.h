@@ -0,0 +1,116 @@
+#ifndef _MOPA_EIT_
+#define _MOPA_EIT_
+#include "inc/io.h"
+#include "inc/commontypes.h"
+#include "inc/descriptors.h"
+
+
+namespace mopa
+{
+
+
+struct eit_event
+{
+	uint16_t event_id;
+	uint64_t start_time;
+	uint32_t duration;
+	uint8_t running_status;
+	uint8_t free_CA_mode;
+	uint16_t descriptors_loop_length;
+	descriptor_vector descriptors;
+	template<class X>
+	void io(X& x)
+	{
+		record<X> r(x,96,DVB_INFO("event"));
+		r.template uint<16>(DVB_VAR(event_id));
+		r.template uint<40>(start_time,DVB_INFO_HINT("start_time",FORMAT_HINT_HEX));
+		r.template uint<24>(duration,DVB_INFO_HINT("duration",FORMAT_HINT_HEX));
+		r.template uint<3>(DVB_VAR(running_status));
+		r.template uint<1>(DVB_VAR(free_CA_mode));
+		r.named_block_begin(12,DVB_INFO("descriptors_loop_length"));
+		descriptors.io(x);
+		descriptors_loop_length=x.named_block_end(DVB_INFO("descriptors"));
+	}
+};
+
+
+
+struct event_information_section
+{
+	uint8_t table_id;
+	uint8_t section_syntax_indicator;
+	uint16_t section_length;
+	uint16_t service_id;
+	uint8_t version_number;
+	uint8_t current_next_indicator;
+	uint8_t section_number;
+	uint8_t last_section_number;
+	uint16_t transport_stream_id;
+	uint16_t original_network_id;
+	uint8_t segment_last_section_number;
+	uint8_t last_table_id;
+	std::vector<eit_event> events;
+	uint32_t CRC;
+	template<class X>
+	void io(X& x)
+	{
+		uint32_t eit_begin=x.ctx->bitpos;
+
+		record<X> h(x,24,DVB_INFO("table_id"));
+		h.template uint<8>(DVB_VAR(table_id));
+		h.template uint<1>(DVB_VAR(section_syntax_indicator));
+		h.template uint_req<1,1>(DVB_INFO("reserved_future_use"));
+		h.template uint_req<2,0x3>(DVB_INFO("reserved"));
+		h.named_block_begin(12,DVB_INFO("section_length"));
+		if(x.is_parsing())
+			if(x.block_size_left()>4093*8)
+			{
+				x.ctx->fail(DVB_INFO("section_length"),ERR_LIMIT,"EIT size exceeds 4096");
+				return;
+			}
+
+		record<X> r(x,88,DVB_INFO("service_id"));
+		r.template uint<16>(DVB_VAR(service_id));
+		r.template uint_req<2,0x3>(DVB_INFO("reserved"));
+		r.template uint<5>(DVB_VAR(version_number));
+		r.template uint<1>(DVB_VAR(current_next_indicator));
+		r.template uint<8>(DVB_VAR(section_number));
+		r.template uint<8>(DVB_VAR(last_section_number));
+		r.template uint<16>(DVB_VAR(transport_stream_id));
+		r.template uint<16>(DVB_VAR(original_network_id));
+		r.template uint<8>(DVB_VAR(segment_last_section_number));
+		r.template uint<8>(DVB_VAR(last_table_id));
+
+		//events take all of section up to CRC
+		if(x.is_validating())
+		{
+			eit_event e;
+			while(x.block_size_left()>32)
+				e.io(x);
+		}
+		else if(x.is_parsing())
+		{
+			events.clear();
+			while(x.block_size_left()>32)
+			{
+				events.push_back(eit_event());
+				events.back().io(x);
+			}
+		}
+		else
+			for(size_t i=0;i<events.size();i++)
+				events[i].io(x);
+
+		uint32_t crc_pos=x.ctx->bitpos;
+		crc_io(x,eit_begin,DVB_VAR(CRC));
+		section_length=x.named_block_end(DVB_INFO("section_length"));
+		crc_late_fix(x,eit_begin,crc_pos,DVB_VAR(CRC));
+		if(!x.is_parsing())
+			if(section_length>4093)
+					throw Exception(x.ctx,DVB_INFO("section_length"),ERR_LIMIT,"EIT size exceeds 4096");
+	}
+};
+
+}
+
+#endif
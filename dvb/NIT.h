@@ -15,13 +15,16 @@ struct ts_specification
 	uint16_t original_network_id;
 	uint8_t reserved_future_use;
 	uint16_t transport_descriptors_length;
-	descriptor_vector transport_descriptors;
-	void io(iox& x)
+	/** Decoded on access, parsed section must outlive it */
+	lazy_descriptor_vector transport_descriptors;
+	template<class X>
+	void io(X& x)
 	{
-		x.uint(16,DVB_VAR(transport_stream_id));
-		x.uint(16,DVB_VAR(original_network_id));
-		x.uint_req(4,0xf,DVB_INFO("reserved_future_use"));
-		x.named_block_begin(12,DVB_INFO("transport_descriptors_length"));
+		record<X> r(x,48,DVB_INFO("ts_specification"));
+		r.template uint<16>(DVB_VAR(transport_stream_id));
+		r.template uint<16>(DVB_VAR(original_network_id));
+		r.template uint_req<4,0xf>(DVB_INFO("reserved_future_use"));
+		r.named_block_begin(12,DVB_INFO("transport_descriptors_length"));
 		transport_descriptors.io(x);
 		transport_descriptors_length=x.named_block_end(DVB_INFO("transport_descriptors"));
 	}
@@ -45,33 +48,37 @@ struct network_information_section
 	uint16_t transport_stream_loop_length;
 	std::vector<ts_specification> ts_loop;
 	uint32_t CRC;
-	void io(iox& x)
+	template<class X>
+	void io(X& x)
 	{
 		uint32_t nit_begin=x.ctx->bitpos;
 
-		x.uint(8,DVB_VAR(table_id));
-		x.uint(1,DVB_VAR(section_syntax_indicator));
-		x.uint_req(1,1,DVB_INFO("reserved_future_use"));
-		x.uint_req(2,0x3,DVB_INFO("reserved"));
-
-		x.named_block_begin(12,DVB_INFO("section_length"));
+		record<X> h(x,24,DVB_INFO("table_id"));
+		h.template uint<8>(DVB_VAR(table_id));
+		h.template uint<1>(DVB_VAR(section_syntax_indicator));
+		h.template uint_req<1,1>(DVB_INFO("reserved_future_use"));
+		h.template uint_req<2,0x3>(DVB_INFO("reserved"));
+		h.named_block_begin(12,DVB_INFO("section_length"));
 		if(x.is_parsing())
 			if(section_length>1021)
-				throw Exception(x.ctx,DVB_INFO("section_length"),"NIT size exceeds 1024");
-
-		x.uint(16,DVB_VAR(network_id));
-		x.uint_req(2,0x3,DVB_INFO("reserved"));
-		x.uint(5,DVB_VAR(version_number));
-		x.uint(1,DVB_VAR(current_next_indicator));
-		x.uint(8,DVB_VAR(section_number));
-		x.uint(8,DVB_VAR(last_section_number));
-		x.uint_req(4,0xf,DVB_INFO("reserved_future_use"));
-
-		x.named_block_begin(12,DVB_INFO("network_descriptors_length"));
+			{
+				x.ctx->fail(DVB_INFO("section_length"),ERR_LIMIT,"NIT size exceeds 1024");
+				return;
+			}
+
+		record<X> r(x,56,DVB_INFO("network_id"));
+		r.template uint<16>(DVB_VAR(network_id));
+		r.template uint_req<2,0x3>(DVB_INFO("reserved"));
+		r.template uint<5>(DVB_VAR(version_number));
+		r.template uint<1>(DVB_VAR(current_next_indicator));
+		r.template uint<8>(DVB_VAR(section_number));
+		r.template uint<8>(DVB_VAR(last_section_number));
+		r.template uint_req<4,0xf>(DVB_INFO("reserved_future_use"));
+		r.named_block_begin(12,DVB_INFO("network_descriptors_length"));
 		network_descriptors.io(x);
 		network_descriptors_length=x.named_block_end(DVB_INFO("network_descriptors_length"));
 
-		x.uint_req(4,0xf,DVB_INFO("reserved_future_use"));
+		x.template uint_req<4,0xf>(DVB_INFO("reserved_future_use"));
 		x.named_block_begin(12,DVB_INFO("transport_stream_loop_length"));
 		vector_io<ts_specification>(x,DVB_VAR(ts_loop));
 		transport_stream_loop_length=x.named_block_end(DVB_INFO("transport_stream_loop_length"));
@@ -82,7 +89,7 @@ struct network_information_section
 		crc_late_fix(x,nit_begin,crc_pos,DVB_VAR(CRC));
 		if(!x.is_parsing())
 			if(section_length>1021)
-					throw Exception(x.ctx,DVB_INFO("section_length"),"NIT size exceeds 1024");
+					throw Exception(x.ctx,DVB_INFO("section_length"),ERR_LIMIT,"NIT size exceeds 1024");
 
 
 	}
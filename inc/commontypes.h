@@ -7,10 +7,65 @@
 namespace mopa
 {
 
-template<typename Item>
-void vector_io(iox& x,std::vector<Item>& list,const iox_info* info=NULL)
+/**
+ * \brief String field that can refer to parsed data
+ * \details
+ * In binary parsing mode \ref short_string_io and \ref fixed_string_io only store
+ * pointer to characters inside parsed buffer, nothing is copied.
+ * Such string_ref is valid as long as parsed buffer is.
+ * Text parsing and assignment from std::string make string_ref own its characters.
+ * Construction modes accept both kinds.\n
+ * Characters are copied only when requested with \ref str.
+ * Copy of string_ref that refers to parsed buffer refers to the same buffer.\n
+ * It is meant for structures that are used only while parsed data is alive,
+ * descriptors of \ref descriptor_vector keep std::string.
+ */
+class string_ref
 {
-	if(x.is_parsing())
+public:
+	string_ref():ref(NULL),len(0){}
+	string_ref(const std::string& s):ref(NULL),len(0),own(s){}
+	string_ref(const char* s):ref(NULL),len(0),own(s){}
+	string_ref& operator=(const std::string& s){ref=NULL;len=0;own=s;return *this;}
+	/**
+	 * \brief Refer to external characters
+	 * \param s - characters, not null-terminated
+	 * \param size - number of characters
+	 */
+	void refer(const char* s, uint32_t size){ref=s;len=size;own.clear();}
+	/** \return true if characters are kept in external buffer */
+	bool is_ref() const {return ref!=NULL;}
+	/** \return pointer to characters, not null-terminated */
+	const char* data() const {return ref!=NULL?ref:own.data();}
+	uint32_t size() const {return ref!=NULL?len:own.size();}
+	/** \return copy of characters */
+	std::string str() const {return std::string(data(),size());}
+	bool operator==(const string_ref& r) const {return size()==r.size() && memcmp(data(),r.data(),size())==0;}
+	bool operator!=(const string_ref& r) const {return !(*this==r);}
+private:
+	const char* ref;
+	uint32_t len;
+	std::string own;
+};
+
+/**
+ * \brief Declares list of structures
+ * \details
+ * In parsing modes items are read as long as current block has data left.
+ * In validation mode single temporary item is reused and \b list is not changed.
+ * In construction modes all items of \b list are written.
+ * It works with \ref iox and with any of \ref ibx, \ref obx, \ref icx, \ref ocx, provided Item::io accepts it.
+ */
+template<typename Item, class X>
+void vector_io(X& x,std::vector<Item>& list,const iox_info* =NULL)
+{
+	if(x.is_validating())
+	{
+		Item i;
+		while(x.block_size_left()>0)
+			i.io(x);
+	}
+	else if(x.is_parsing())
 	{
 		list.clear();
 		while(x.block_size_left()>0)
@@ -30,10 +85,32 @@ void vector_io(iox& x,std::vector<Item>& list,const iox_info* info=NULL)
 	}
 }
 
-void short_string_io(iox& x,std::string& str,const iox_info* info=NULL);
-void fixed_string_io(iox& x,uint32_t num_chars,std::string& str,const iox_info* info=NULL);
+/**
+ * \brief String preceded by its length byte
+ * \details Defined for all facades, \b S is std::string or \ref string_ref.
+ */
+template<class X,class S>
+void short_string_io(X& x,S& str,const iox_info* info=NULL);
+/**
+ * \brief String of \b num_chars characters
+ * \details Defined for all facades, \b S is std::string or \ref string_ref.
+ */
+template<class X,class S>
+void fixed_string_io(X& x,uint32_t num_chars,S& str,const iox_info* info=NULL);
 
 void crc_io(iox& x,uint32_t started_at,uint32_t& crc,const iox_info* info=NULL);
+void crc_io(ibx& x,uint32_t started_at,uint32_t& crc,const iox_info* info=NULL);
+void crc_io(obx& x,uint32_t started_at,uint32_t& crc,const iox_info* info=NULL);
+void crc_io(icx& x,uint32_t started_at,uint32_t& crc,const iox_info* info=NULL);
+void crc_io(ocx& x,uint32_t started_at,uint32_t& crc,const iox_info* info=NULL);
+void crc_io(ipx& x,uint32_t started_at,uint32_t& crc,const iox_info* info=NULL);
+void crc_io(omx& x,uint32_t started_at,uint32_t& crc,const iox_info* info=NULL);
 void crc_late_fix(iox& x,uint32_t started_at,uint32_t crc_pos,uint32_t& crc,const iox_info* info);
+void crc_late_fix(ibx& x,uint32_t started_at,uint32_t crc_pos,uint32_t& crc,const iox_info* info);
+void crc_late_fix(obx& x,uint32_t started_at,uint32_t crc_pos,uint32_t& crc,const iox_info* info);
+void crc_late_fix(icx& x,uint32_t started_at,uint32_t crc_pos,uint32_t& crc,const iox_info* info);
+void crc_late_fix(ocx& x,uint32_t started_at,uint32_t crc_pos,uint32_t& crc,const iox_info* info);
+void crc_late_fix(ipx& x,uint32_t started_at,uint32_t crc_pos,uint32_t& crc,const iox_info* info);
+void crc_late_fix(omx& x,uint32_t started_at,uint32_t crc_pos,uint32_t& crc,const iox_info* info);
 }
 #endif
@@ -0,0 +1,86 @@
+#ifndef __CRC_H__
+#define __CRC_H__
+
+#include <stdint.h>
+
+/*!
+ * \def MOPA_CRC_SLICES
+ * Bytes processed per step by \ref mopa::dvb_crc32.
+ * 1 selects single table, 8 and 16 select slicing-by-8 and slicing-by-16.
+ */
+#ifndef MOPA_CRC_SLICES
+#define MOPA_CRC_SLICES 16
+#endif
+
+/*!
+ * \def MOPA_CRC_CLMUL
+ * If nonzero, \ref mopa::dvb_crc32 uses carry-less multiplication when cpu supports it.
+ * Available on x86 only.
+ */
+#ifndef MOPA_CRC_CLMUL
+#if defined(__x86_64__) || defined(__i386__)
+#define MOPA_CRC_CLMUL 1
+#else
+#define MOPA_CRC_CLMUL 0
+#endif
+#endif
+
+namespace mopa
+{
+/**
+ * \brief MPEG-2 CRC32 of section data
+ *
+ * Polynomial 0x04C11DB7, not reflected, initial value 0xffffffff, no final xor.
+ * CRC of section including its CRC_32 field is 0.
+ * Uses carry-less multiplication if available, see \ref MOPA_CRC_CLMUL,
+ * otherwise implementation selected by \ref MOPA_CRC_SLICES.
+ */
+uint32_t dvb_crc32(const uint8_t *data, int len);
+/**
+ * \brief Continue CRC32 calculation
+ *
+ * dvb_crc32_update(dvb_crc32(a,a_len),b,b_len) gives CRC of a followed by b.
+ * \param crc - CRC of preceding data, or 0xffffffff at start
+ */
+uint32_t dvb_crc32_update(uint32_t crc, const uint8_t *data, int len);
+/**
+ * \brief Join CRC32 of two adjacent blocks
+ *
+ * Allows CRC of large buffer to be calculated in chunks independently.
+ * \param crc_a - dvb_crc32 of first block
+ * \param crc_b - dvb_crc32 of second block
+ * \param len_b - length of second block
+ * \return dvb_crc32 of first block followed by second, cost is O(log len_b)
+ */
+uint32_t dvb_crc32_combine(uint32_t crc_a, uint32_t crc_b, int len_b);
+/**
+ * \brief Correct CRC32 after data is modified in place
+ *
+ * Bytes at \b offset of data are changed by xor with \b delta.
+ * Cost depends on \b delta_len and O(log len), not on \b len.
+ * \param crc - dvb_crc32 of data before modification
+ * \param len - length of data
+ * \param offset - position of modified bytes
+ * \param delta - old bytes xor new bytes
+ * \param delta_len - number of modified bytes
+ * \return dvb_crc32 of modified data
+ */
+uint32_t dvb_crc32_patch(uint32_t crc, int len, int offset, const uint8_t *delta, int delta_len);
+/**
+ * \brief Variants of \ref dvb_crc32, one byte, 8 bytes and 16 bytes per step.
+ * \details All give the same result, they are exposed for validation and benchmarking.
+ */
+uint32_t dvb_crc32_bytewise(const uint8_t *data, int len);
+uint32_t dvb_crc32_slice8(const uint8_t *data, int len);
+uint32_t dvb_crc32_slice16(const uint8_t *data, int len);
+#if MOPA_CRC_CLMUL
+/**
+ * \brief Variant of \ref dvb_crc32 that folds data with PCLMULQDQ
+ * \details Must be called only if \ref dvb_crc32_clmul_supported returns true.
+ */
+uint32_t dvb_crc32_clmul(const uint8_t *data, int len);
+bool dvb_crc32_clmul_supported();
+#endif
+}
+
+#endif
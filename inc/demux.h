@@ -0,0 +1,61 @@
+#ifndef __DEMUX_H__
+#define __DEMUX_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include "inc/merger.h"
+
+/**
+ * \brief Extraction of PSI/SI sections from complete transport stream
+ *
+ * Packets of PIDs selected in filter are passed to \ref psi_extractor of their PID,
+ * other packets are skipped after one lookup. Extractor state is created when PID is added,
+ * there is no allocation per packet.
+ * Initially PAT 0x00, CAT 0x01, NIT 0x10, SDT/BAT 0x11, EIT 0x12 and TDT/TOT 0x14 are selected.
+ */
+class psi_demux
+{
+public:
+	/**
+	 * \brief Callback for sections
+	 * \details \b crc_ok is true if CRC is not checked, see \ref set_crc_check.
+	 */
+	typedef void (*section_ready)(void* ctx, uint16_t pid, const uint8_t* section, size_t size, bool crc_ok);
+	static psi_demux* create(size_t max_section_size=4096,int max_dbg=0);
+	virtual ~psi_demux(){};
+	/**
+	 * \brief Process TS packet of any PID
+	 * \details Packets without sync byte or with transport_error_indicator are skipped.
+	 */
+	virtual void ts_packet(const uint8_t* packet)=0;
+	/**
+	 * \brief Process \b n consecutive TS packets, same as \ref ts_packet for each of them
+	 * \details Runs of packets of the same PID are passed to extractor at once.
+	 * \param stride - distance between packets, larger than 188 for 192 and 204 byte framing
+	 */
+	virtual void ts_packets(const uint8_t* packets, size_t n, size_t stride=188)=0;
+	virtual void on_section_ready(void* ctx, section_ready callback)=0;
+	/**
+	 * \brief Select PID for extraction of sections
+	 */
+	virtual void add_pid(uint16_t pid)=0;
+	/**
+	 * \brief Deselect PID and discard its partial section
+	 * \note Must not be called from callback for section of the same PID.
+	 */
+	virtual void remove_pid(uint16_t pid)=0;
+	virtual bool has_pid(uint16_t pid)=0;
+	/**
+	 * \brief Add PMT PIDs listed in each received PAT
+	 * \details PAT sections are used only if their CRC is correct, whatever \ref set_crc_check mode is.
+	 * When all sections of new PAT version are received, PIDs that were added for PAT
+	 * and are no longer listed in it are removed. PIDs selected with \ref add_pid are kept.
+	 */
+	virtual void set_follow_pat(bool follow)=0;
+	/**
+	 * \brief CRC check for all PIDs, see \ref psi_extractor::set_crc_check
+	 */
+	virtual void set_crc_check(psi_extractor::crc_check mode)=0;
+};
+
+#endif
@@ -7,32 +7,62 @@
 namespace mopa
 {
 
+/*!
+ * \def DVB_DESCRIPTOR_IO
+ * Declares virtual io() for every I/O facade, each forwarding to template io() of descriptor.
+ * Descriptors are held by pointer in \ref descriptor_vector, so static type of facade
+ * must survive one virtual call. It must be placed in every class derived from \ref descriptor.
+ */
+#define DVB_DESCRIPTOR_IO \
+	virtual void io(iox& x){io<iox>(x);} \
+	virtual void io(ibx& x){io<ibx>(x);} \
+	virtual void io(obx& x){io<obx>(x);} \
+	virtual void io(icx& x){io<icx>(x);} \
+	virtual void io(ocx& x){io<ocx>(x);} \
+	virtual void io(ipx& x){io<ipx>(x);} \
+	virtual void io(ivx& x){io<ivx>(x);} \
+	virtual void io(omx& x){io<omx>(x);}
+
 struct descriptor
 {
 	uint8_t tag;
 	uint8_t length;
-	virtual void io(iox& x)
+	template<class X>
+	void io(X& x)
 	{
-		x.uint(8,DVB_VAR(tag));
+		x.template uint<8>(DVB_VAR(tag));
 		x.named_block_begin(8,DVB_INFO("length"));
 		//switch
 		length=x.named_block_end(DVB_INFO("descriptor_content"));
 	}
+	DVB_DESCRIPTOR_IO
 	virtual ~descriptor(){};
 	virtual descriptor* dup()=0;
 };
 descriptor* descriptor_factory(uint8_t tag);
 
+/*!
+ * \def DVB_DESCRIPTORS(D)
+ * List of known descriptors. \b D is invoked with (tag, type) for each of them.
+ * Descriptors with other tags are handled by \ref unknown_descriptor.
+ */
+#define DVB_DESCRIPTORS(D) \
+	D(0x41,service_list_descriptor) \
+	D(0x44,cable_delivery_system_descriptor) \
+	D(0x70,adaptation_field_data_descriptor)
+
 
 struct adaptation_field_data_descriptor : public descriptor
 {
 	uint8_t adaptation_field_data_identifier;
-	void io(iox& x)
+	template<class X>
+	void io(X& x)
 	{
 		x.named_block_begin(8,DVB_INFO("length"));
-		x.uint(8,DVB_VAR(adaptation_field_data_identifier));
+		x.template uint<8>(DVB_VAR(adaptation_field_data_identifier));
 		length=x.named_block_end(DVB_INFO("descriptor_content"));
 	}
+	DVB_DESCRIPTOR_IO
 	descriptor* dup(){return new adaptation_field_data_descriptor(*this);};
 };
 
@@ -43,21 +73,25 @@ struct service_list_descriptor : public descriptor
 	{
 		uint16_t service_id;
 		uint8_t service_type;
-		void io(iox& x)
+		template<class X>
+		void io(X& x)
 		{
-			x.uint(16,DVB_VAR(service_id));
-			x.uint(8,DVB_VAR(service_type));
+			record<X> r(x,24,DVB_INFO("service"));
+			r.template uint<16>(DVB_VAR(service_id));
+			r.template uint<8>(DVB_VAR(service_type));
 		}
 	};
 	std::vector<service> services;
-	void io(iox& x)
+	template<class X>
+	void io(X& x)
 	{
 		if(!x.is_parsing())
-			x.uint(8,DVB_VAR(tag));
+			x.template uint<8>(DVB_VAR(tag));
 		x.named_block_begin(8,DVB_INFO("length"));
 		vector_io<service>(x,DVB_VAR(services));
 		length=x.named_block_end(DVB_INFO("descriptor_content"));
 	}
+	DVB_DESCRIPTOR_IO
 	descriptor* dup(){return new service_list_descriptor(*this);};
 };
 
@@ -68,20 +102,23 @@ struct cable_delivery_system_descriptor : public descriptor
 	uint8_t modulation;
 	uint32_t symbol_rate;
 	uint8_t FEC_inner;
-	void io(iox& x)
+	template<class X>
+	void io(X& x)
 	{
 		if(!x.is_parsing())
-			x.uint(8,DVB_VAR(tag));
+			x.template uint<8>(DVB_VAR(tag));
 		x.named_block_begin(8,DVB_INFO("length"));
-		x.uint(32,frequency,DVB_INFO_HINT("frequency",FORMAT_HINT_HEX));
+		record<X> r(x,88,DVB_INFO("descriptor_content"));
+		r.template uint<32>(frequency,DVB_INFO_HINT("frequency",FORMAT_HINT_HEX));
 		//x.uint(12,DVB_VAR(reserved_future_use));
-		x.uint_req(12,(1<<12)-1,DVB_INFO("reserved_future_use"));
-		x.uint(4,DVB_VAR(FEC_outer));
-		x.uint(8,DVB_VAR(modulation));
-		x.uint(28,DVB_VAR(symbol_rate));
-		x.uint(4,DVB_VAR(FEC_inner));
+		r.template uint_req<12,(1<<12)-1>(DVB_INFO("reserved_future_use"));
+		r.template uint<4>(DVB_VAR(FEC_outer));
+		r.template uint<8>(DVB_VAR(modulation));
+		r.template uint<28>(DVB_VAR(symbol_rate));
+		r.template uint<4>(DVB_VAR(FEC_inner));
 		length=x.named_block_end(DVB_INFO("descriptor_content"));
 	}
+	DVB_DESCRIPTOR_IO
 	descriptor* dup(){return new cable_delivery_system_descriptor(*this);};
 };
 
@@ -98,7 +135,8 @@ struct extended_event_descriptor : public descriptor
 	{
 		std::string item_description;
 		std::string item;
-		void io(iox& x)
+		template<class X>
+		void io(X& x)
 		{
 			short_string_io(x,DVB_VAR(item_description));
 			short_string_io(x,DVB_VAR(item));
@@ -106,18 +144,20 @@ struct extended_event_descriptor : public descriptor
 	};
 	std::vector<item> items;
 	std::string text;
-	void io(iox& x)
+	template<class X>
+	void io(X& x)
 	{
-		x.uint(8,DVB_VAR(descriptor_tag));
-		x.uint(8,DVB_VAR(descriptor_length));
-		x.uint(4,DVB_VAR(descriptor_number));
-		x.uint(4,DVB_VAR(last_descriptor_number));
+		x.template uint<8>(DVB_VAR(descriptor_tag));
+		x.template uint<8>(DVB_VAR(descriptor_length));
+		x.template uint<4>(DVB_VAR(descriptor_number));
+		x.template uint<4>(DVB_VAR(last_descriptor_number));
 		fixed_string_io(x,3,DVB_VAR(ISO_639_language_code));
 		x.named_block_begin(8,DVB_INFO("length_of_items"));
 		vector_io(x,DVB_VAR(items));
 		length_of_items=x.named_block_end(DVB_INFO("items"));
 		short_string_io(x,text,NULL);
 	}
+	DVB_DESCRIPTOR_IO
 	descriptor* dup(){return new extended_event_descriptor(*this);};
 };
 
@@ -125,14 +165,16 @@ struct extended_event_descriptor : public descriptor
 struct unknown_descriptor : public descriptor
 {
 	std::string data;
-	void io(iox& x)
+	template<class X>
+	void io(X& x)
 	{
 		if(!x.is_parsing())
-			x.uint(8,DVB_VAR(tag));
-		x.uint(8,DVB_VAR(length));
+			x.template uint<8>(DVB_VAR(tag));
+		x.template uint<8>(DVB_VAR(length));
 		if(length>0)
 		fixed_string_io(x,length,DVB_VAR(data));
 	}
+	DVB_DESCRIPTOR_IO
 	descriptor* dup(){return new unknown_descriptor(*this);};
 };
 
@@ -143,8 +185,121 @@ struct descriptor_vector : public std::vector<struct descriptor*>
 	descriptor_vector();
 	descriptor_vector(const descriptor_vector& x);
 	descriptor_vector& operator=(descriptor_vector const &x);
+	template<class X>
+	void io(X& x);
+	void purge();
+};
+
+/**
+ * \brief Calls \b f with temporary descriptor of type selected by \b tag
+ * \details Descriptor lives on stack, so nothing is allocated. Used by validation.
+ */
+template<class F>
+void descriptor_visit(uint8_t tag, F f)
+{
+	switch(tag)
+	{
+#define DVB_DESCRIPTOR_VISIT(tag,type) case tag: {type d; f(d);} break;
+		DVB_DESCRIPTORS(DVB_DESCRIPTOR_VISIT)
+#undef DVB_DESCRIPTOR_VISIT
+		default: {unknown_descriptor d; f(d);} break;
+	}
+}
+
+template<class X>
+void descriptor_vector::io(X& x)
+{
+	if(x.is_validating())
+	{
+		while(x.block_size_left()>0)
+		{
+			uint8_t tag;
+			x.template uint<8>(DVB_VAR(tag));
+			descriptor_visit(tag,[&x,tag](descriptor& d){d.tag=tag;d.io(x);});
+		}
+	}
+	else if(x.is_parsing())
+	{
+		purge();
+		while(x.block_size_left()>0)
+		{
+			//read tag ahead
+			uint8_t tag;
+			x.template uint<8>(DVB_VAR(tag));
+			descriptor* dsc=descriptor_factory(tag);
+			push_back(dsc);
+			dsc->tag=tag;
+			back()->io(x);
+		}
+	}
+	else
+	{
+		for(size_t i=0;i<size();i++)
+		{
+			this->operator[](i)->io(x);
+		}
+	}
+}
+
+/**
+ * \brief Descriptor loop decoded on access
+ * \details
+ * In binary parsing mode only tag and length of each descriptor are read,
+ * together with location of loop in parsed data. Descriptor is decoded when it is
+ * accessed with \ref at or \ref find. Parsed data must stay valid as long as loop is used.\n
+ * In binary construction mode descriptors that were never decoded are copied verbatim from parsed data,
+ * decoded or added ones are constructed with their io().\n
+ * In text modes all descriptors are decoded, as text always lists their content.
+ * Validation decodes content of each descriptor too, so it accepts the same data as \ref descriptor_vector.\n
+ * Used for transport descriptors of NIT.
+ */
+struct lazy_descriptor_vector
+{
+	lazy_descriptor_vector();
+	~lazy_descriptor_vector();
+	lazy_descriptor_vector(const lazy_descriptor_vector& x);
+	lazy_descriptor_vector& operator=(lazy_descriptor_vector const &x);
 	void io(iox& x);
+	void io(ibx& x);
+	void io(obx& x);
+	void io(icx& x);
+	void io(ocx& x);
+	void io(ipx& x);
+	void io(ivx& x);
+	void io(omx& x);
+	/** \return number of descriptors in loop */
+	size_t size() const {return entries.size();}
+	/** \return tag of i-th descriptor, without decoding it */
+	uint8_t tag(size_t i) const {return entries[i].tag;}
+	/** \return true if i-th descriptor has already been decoded */
+	bool is_decoded(size_t i) const {return entries[i].decoded!=NULL;}
+	/**
+	 * \brief Access descriptor by index
+	 * \return i-th descriptor, decoded on first access
+	 * \throws mopa::Exception if descriptor content is malformed
+	 */
+	descriptor* at(size_t i);
+	descriptor* operator[](size_t i) {return at(i);}
+	/**
+	 * \brief Access descriptor by tag
+	 * \param tag - tag to look for
+	 * \param from - index to start search from
+	 * \return first descriptor with \b tag at index \b from or later, NULL if there is none
+	 */
+	descriptor* find(uint8_t tag, size_t from=0);
+	/** \brief Appends descriptor, which becomes owned by loop */
+	void push_back(descriptor* d);
 	void purge();
+private:
+	struct entry
+	{
+		uint32_t offset;	/**< offset of descriptor tag in raw */
+		uint8_t tag;
+		uint8_t length;
+		descriptor* decoded;
+	};
+	const uint8_t* raw;
+	std::vector<entry> entries;
 };
 
 
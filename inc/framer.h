@@ -0,0 +1,49 @@
+#ifndef __FRAMER_H__
+#define __FRAMER_H__
+
+#include <stdint.h>
+#include <cstddef>
+
+/**
+ * \brief Finds TS packets in stream of bytes
+ *
+ * Detects packet size of 188 (plain TS), 192 (M2TS, 4 byte timestamp before each packet)
+ * or 204 (16 bytes of Reed-Solomon parity after each packet), and position of sync bytes.
+ * Input may start in the middle of packet and may be split at any byte.
+ * When sync byte is not found where expected, framer searches for sync again.
+ *
+ * Packets are passed in place from input, except the ones that are split between calls of \ref data.
+ */
+class ts_framer
+{
+public:
+	/**
+	 * \brief Callback for packets found
+	 * \param packets - first TS packet, starting with sync byte
+	 * \param n - number of packets
+	 * \param stride - distance between packets
+	 */
+	typedef void (*packets_ready)(void* ctx, const uint8_t* packets, size_t n, size_t stride);
+	static ts_framer* create();
+	virtual ~ts_framer(){};
+	/**
+	 * \brief Process next part of input
+	 */
+	virtual void data(const uint8_t* bytes, size_t len)=0;
+	virtual void on_packets_ready(void* ctx, packets_ready callback)=0;
+	/**
+	 * \brief Detected packet size
+	 * \return 188, 192 or 204, 0 when not synchronized
+	 */
+	virtual size_t packet_size()=0;
+	/**
+	 * \brief Number of input bytes that were not part of any packet
+	 */
+	virtual uint64_t skipped_bytes()=0;
+	/**
+	 * \brief Number of times synchronization was lost
+	 */
+	virtual uint32_t sync_losses()=0;
+};
+
+#endif
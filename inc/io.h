@@ -47,6 +47,8 @@ struct PDC_descriptor
  * | Parse text input to C++ data structures| \ref mopa::iox::parse_text |
  * | Construct text output from C++ data structures|\ref mopa::iox::construct_text |
  *
+ * Variants of binary modes are \ref mopa::iox::validate_binary and \ref mopa::iox::measure_binary .
+ *
  * In all cases C++ data structures are either source or target of operation.
  *
  * In most common cases operations are performed on top-level \ref mopa::iox class.
@@ -85,7 +87,10 @@ struct PDC_descriptor
 #include <vector>
 #include <stdint.h>
 #include <stdarg.h>
+#include <string.h>
 #include <string>
+#include <type_traits>
+#include <new>
 
 namespace mopa
 {
@@ -97,6 +102,9 @@ class ibx;
 class obx;
 class icx;
 class ocx;
+class ipx;
+class ivx;
+class omx;
 /**
  * \brief Adds metadata to mopa operation
  *
@@ -125,6 +133,91 @@ const uint32_t FORMAT_HINT_DEC=0x0;	/**< decimal output. this is default. used i
 const uint32_t FORMAT_HINT_HEX=0x1;	/**< hexadecimal output. used in iox_info.hint*/
 const uint32_t FORMAT_HINT_BIN=0x2;	/**< binary output. used in iox_info.hint*/
 
+/**
+ * \brief Class of error, see \ref io_error::code
+ */
+enum error_code
+{
+	ERR_OTHER=0,	/**< not classified */
+	ERR_NO_SPACE,	/**< not enough bits left in block or bitstream */
+	ERR_VALUE,		/**< value does not fit in field, or differs from required one */
+	ERR_ALIGNMENT,	/**< field, block or CRC not byte-aligned */
+	ERR_BLOCK,		/**< blocks nested too deep, unmatched or not fully consumed */
+	ERR_CRC,		/**< CRC mismatch */
+	ERR_SYNTAX,		/**< malformed text input */
+	ERR_LIMIT		/**< limit imposed by syntactic structure, like maximum size of section */
+};
+
+/*!
+ * \def MOPA_ERROR_ARGS
+ * Maximum number of arguments of error detail recorded in \ref io_error.
+ */
+#ifndef MOPA_ERROR_ARGS
+#define MOPA_ERROR_ARGS 4
+#endif
+/*!
+ * \def MOPA_ERROR_SCOPES
+ * Number of innermost enclosing blocks recorded in \ref io_error. Outer ones are only counted.
+ */
+#ifndef MOPA_ERROR_SCOPES
+#define MOPA_ERROR_SCOPES 8
+#endif
+
+class ioCtx;
+
+/**
+ * \brief Compact record of error
+ * \details
+ * Holds what is needed to describe error: its class, faulting operation, position,
+ * enclosing blocks and unformatted detail. It does not allocate.
+ * Textual form is produced only by \ref message.
+ */
+struct io_error
+{
+	/** \brief Block enclosing faulting operation */
+	struct scope
+	{
+		const iox_info* info;
+		uint32_t bitpos_at_enter;
+		uint32_t bitlimit_at_enter;
+	};
+	/** \brief Argument of error detail, as taken from variable argument list */
+	union arg
+	{
+		uint64_t u;
+		const char* s;
+	};
+	error_code code;
+	/** Location of operation that faulted, may be NULL */
+	const iox_info* info;
+	uint32_t bitpos;
+	uint32_t bitlimit;
+	bool parsing;
+	bool binary;
+	/** Number of blocks entered at fault */
+	uint32_t depth;
+	/** Enclosing blocks, innermost first. Only first MOPA_ERROR_SCOPES of \b depth are kept */
+	scope scopes[MOPA_ERROR_SCOPES];
+	/** Line and column of fault, only in text parsing */
+	uint32_t line;
+	uint32_t column;
+	/** Format of error detail, fmt of \ref Exception */
+	const char* fmt;
+	/** Arguments for fmt. Strings are kept as pointers, so they must outlive error */
+	arg args[MOPA_ERROR_ARGS];
+	uint32_t nargs;
+	/**
+	 * \brief Render error
+	 * \return Same text as Exception::message
+	 */
+	std::string message() const;
+	/**
+	 * \brief Fill record from state of context
+	 * \details Only arguments of \b fmt are taken, nothing is formatted.
+	 */
+	void record(const ioCtx* x, const iox_info* at, error_code c, const char* format, va_list ap);
+};
+
 /**
  * \addtogroup IOCTX Helper contexts for IO
  *
@@ -153,9 +246,36 @@ public:
 	/** \brief Checks if parsing
 	 * \return true iff in one of parsing modes*/
 	inline bool is_parsing() const {return parsing;}
+	/** \brief Checks if validating
+	 * \return true iff in validation mode, which is variant of binary parsing*/
+	inline bool is_validating() const {return validating;}
+	/** \brief Checks if measuring
+	 * \return true iff in measure mode, which is variant of binary construction*/
+	inline bool is_measuring() const {return measuring;}
+	/** \brief Report parse errors without throwing.
+	 *  \details When set, checks of parsing facades record first error in ioCtx::error,
+	 *  set ioCtx::failed and return. Exceptions still thrown, for example by construction facades,
+	 *  only record \ref io_error and leave Exception::message empty.
+	 *  It is set by \ref try_io.*/
+	bool nothrow;
+	/** \brief Error was recorded in ioCtx::nothrow mode.
+	 *  \details Once set, blocks are not entered or left, \ref record skips its fields
+	 *  and block_size_left() returns 0, so io() returns quickly.*/
+	bool failed;
+	/** \brief First error recorded in ioCtx::nothrow mode */
+	io_error error;
+	/**
+	 * \brief Report error
+	 * \details Throws \ref Exception, unless ioCtx::nothrow is set.
+	 * Then error is recorded, if it is first one, and function returns.
+	 * Caller must return at once, with neutral result.
+	 */
+	void fail(const iox_info* info, error_code code, const char* fmt, ...);
 private:
 	bool parsing;
 	bool binary;
+	bool validating;
+	bool measuring;
 	friend class iox;
 };
 /** \brief Context for output
@@ -170,6 +290,89 @@ class oCtx : public ioCtx
 class iCtx : public ioCtx
 {};
 
+/**
+ * \brief Loads 8 bytes as big-endian 64 bit word.
+ * \details Single unaligned load, byte-swapped on little-endian hosts.
+ */
+inline uint64_t load_be64(const uint8_t* p)
+{
+	uint64_t w;
+	memcpy(&w,p,sizeof(w));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	w=__builtin_bswap64(w);
+#endif
+	return w;
+}
+/**
+ * \brief Stores 64 bit word as 8 big-endian bytes.
+ * \details Single unaligned store, byte-swapped on little-endian hosts.
+ */
+inline void store_be64(uint8_t* p, uint64_t w)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	w=__builtin_bswap64(w);
+#endif
+	memcpy(p,&w,sizeof(w));
+}
+
+/*!
+ * \def MOPA_SCOPE_INLINE_DEPTH
+ * Number of nested blocks kept inside context without allocating memory.
+ * Section, loop, descriptor and inner loop fit with margin.
+ */
+#ifndef MOPA_SCOPE_INLINE_DEPTH
+#define MOPA_SCOPE_INLINE_DEPTH 8
+#endif
+/*!
+ * \def MOPA_SCOPE_MAX_DEPTH
+ * Maximum nesting of blocks. Entering block beyond it throws \ref mopa::Exception.
+ */
+#ifndef MOPA_SCOPE_MAX_DEPTH
+#define MOPA_SCOPE_MAX_DEPTH 64
+#endif
+
+/**
+ * \brief Stack of block scopes
+ * \details
+ * First \b N scopes are stored inside object, deeper ones spill to heap.
+ * Capacity is limited to MOPA_SCOPE_MAX_DEPTH, user must check \ref full before \ref push_back.
+ * Only operations needed by contexts are provided.
+ */
+template<class S, unsigned N=MOPA_SCOPE_INLINE_DEPTH>
+class inline_stack
+{
+public:
+	inline_stack():depth(0){}
+	inline uint32_t size() const {return depth;}
+	inline bool empty() const {return depth==0;}
+	/** \return true if no more scopes can be pushed */
+	inline bool full() const {return depth>=MOPA_SCOPE_MAX_DEPTH;}
+	/** \brief Maximum depth of stack */
+	static uint32_t max_size() {return MOPA_SCOPE_MAX_DEPTH;}
+	inline S& operator[](uint32_t i) {return i<N?items[i]:spill[i-N];}
+	inline const S& operator[](uint32_t i) const {return i<N?items[i]:spill[i-N];}
+	inline S& back() {return (*this)[depth-1];}
+	inline void push_back(const S& s)
+	{
+		if(depth<N)
+			items[depth]=s;
+		else
+		{
+			if(spill.size()<=depth-N)
+				spill.resize(depth-N+1);
+			spill[depth-N]=s;
+		}
+		depth++;
+	}
+	inline void pop_back() {depth--;}
+	/** \brief Empties stack. Spilled storage is kept for reuse. */
+	inline void clear() {depth=0;}
+private:
+	S items[N];
+	std::vector<S> spill;
+	uint32_t depth;
+};
+
 /**
  * \brief Scope for binary output mode
  */
@@ -204,12 +407,33 @@ public:
 	 * \details This field is filled by iox::construct_binary. It must not been changed.
 	 */
 	uint8_t* data;
+	/**
+	 * \brief Size of obCtx.data in bytes.
+	 * \details Stores of obCtx.acc never write beyond it, regardless of ioCtx.bitlimit.
+	 */
+	uint32_t data_size;
 	/**
 	 * \brief Stack to track syntactic blocks.
 	 * \details This is used by obx::block_begin and obx::block_end.
 	 * It is unadvised to change it in any case outside those functions.
 	 */
-	std::vector<obScope> scope_stack;
+	inline_stack<obScope> scope_stack;
+	/**
+	 * \brief Accumulated bitstream word.
+	 * \details Holds bits from obCtx.acc_pos up to obCtx.wpos, most significant bit first.
+	 * Bits after obCtx.wpos are 0.
+	 */
+	uint64_t acc;
+	/**
+	 * \brief Position of first bit held in obCtx.acc. It is always byte-aligned.
+	 */
+	uint32_t acc_pos;
+	/**
+	 * \brief End of bits written so far.
+	 * \details Writes at this position are appended to obCtx.acc. Writes before it are back-patches.
+	 * It is moved by \ref obCtx::advance when ioCtx.bitpos jumps over reserved or memcpy'd bytes.
+	 */
+	uint32_t wpos;
 	/**
 	 * \brief Puts integer to bitstream.
 	 * \details
@@ -224,74 +448,152 @@ public:
 	 *        |   |   |   |v.6|v.5|v.4|v.3|v.2|v.1|v.0|   |   |   |   |   |   |
 	 * \endcode
 	 * After writing ioCtx.bitpos is moved to new position.\n
+	 * Fields written in order are shifted into obCtx.acc, which is then stored to obCtx.data.
+	 * No byte of obCtx.data is read in this case, and no byte after obCtx.wpos is written.
+	 * When ioCtx.bitpos was moved back (for example to write length of block in \ref ox::named_block_end)
+	 * bytes are updated with read-modify-write, see \ref obCtx::nocheck_patch.\n
 	 * Function does not perform any range-checks. It is error to write if ioCtx.bitpos+<b>bitsize</b>>ioCtx.bitlimit.
 	 *
-	 * \note There are uint8_t, uint16_t and uint32_t variants.
+	 * \note There are uint8_t, uint16_t, uint32_t and uint64_t variants.
 	 */
 	inline void nocheck_uint(int bitsize, uint8_t val)
 	{
-		if((bitpos&7) + bitsize<=8)
+		nocheck_bits(bitsize,val);
+	}
+	inline void nocheck_uint(int bitsize, uint16_t val)
+	{
+		nocheck_bits(bitsize,val);
+	}
+	inline void nocheck_uint(int bitsize, uint32_t val)
+	{
+		nocheck_bits(bitsize,val);
+	}
+	inline void nocheck_uint(int bitsize, uint64_t val)
+	{
+		if(bitsize<=57)
 		{
-			//fast route
-			uint8_t mask=(1<<bitsize)-1;
-			int lshift=8-(bitpos&7)-bitsize;
-			data[bitpos/8]= (data[bitpos/8] & ~(mask << lshift )) | (val << lshift);
+			nocheck_bits(bitsize,val);
+			return;
 		}
-		else
+		nocheck_bits(bitsize-32,val>>32);
+		nocheck_bits(32,val&0xffffffff);
+	}
+	/**
+	 * \brief Puts integer to bitstream.
+	 * \details See \ref obCtx::nocheck_uint. \b bitsize must be in range 1..57.
+	 */
+	inline void nocheck_bits(int bitsize, uint64_t val)
+	{
+		if(bitpos!=wpos)
 		{
-			uint16_t tmp;
-			tmp=(data[bitpos/8] << 8) | data[(bitpos/8)+1];
-			uint16_t mask=(1<<bitsize)-1;
-			int lshift=16-(bitpos&7)-bitsize;
-			tmp=(tmp & ~(mask << lshift)) | (val << lshift);
-			data[bitpos/8] = tmp>>8;
-			data[bitpos/8+1] = tmp&0xff;
+			if(bitpos<wpos)
+			{
+				nocheck_patch(bitsize,val);
+				return;
+			}
+			reseat();
 		}
-		bitpos+=bitsize;
+		uint32_t off=wpos-acc_pos;
+		if(off+bitsize>64)
+		{
+			//retire bytes that are complete, they are already stored
+			uint32_t n=off&~7U;
+			acc=n<64?acc<<n:0;
+			acc_pos+=n;
+			off-=n;
+		}
+		acc|=val<<(64-off-bitsize);
+		wpos+=bitsize;
+		bitpos=wpos;
+		store();
 	}
-	inline void nocheck_uint(int bitsize, uint16_t val)
+	/**
+	 * \brief Puts integer of compile-time width to bitstream.
+	 * \details See \ref ibCtx::nocheck_bits<BITS>.
+	 */
+	template<int BITS>
+	inline void nocheck_bits(uint64_t val)
 	{
-		if((bitpos&7) + bitsize<=16)
+		if constexpr(BITS>57)
 		{
-			//fast route
-			uint16_t mask=(1<<bitsize)-1;
-			int lshift=16-(bitpos&7)-bitsize;
-			uint16_t tmp;
-			tmp=(data[bitpos/8]<<8) | data[bitpos/8+1];
-			tmp=(tmp & ~(mask << lshift )) | (val << lshift);
-			data[bitpos/8] = tmp>>8;
-			data[bitpos/8+1] = tmp&0xff;
+			nocheck_bits<BITS-32>(val>>32);
+			nocheck_bits<32>(val&0xffffffff);
 		}
 		else
+			nocheck_bits(BITS,val);
+	}
+	/**
+	 * \brief Overwrites integer in already constructed part of bitstream.
+	 * \details
+	 * Bytes covering \b bitsize bits at ioCtx.bitpos are read, modified and written back.
+	 * If they overlap obCtx.acc, it is reloaded so later stores keep the patched bits.
+	 */
+	void nocheck_patch(int bitsize, uint64_t val)
+	{
+		uint32_t byte=bitpos/8;
+		uint32_t n=(bitpos+bitsize+7)/8-byte;
+		uint64_t w=0;
+		for(uint32_t i=0;i<n;i++)
+			w=(w<<8)|data[byte+i];
+		int lshift=n*8-(bitpos&7)-bitsize;
+		uint64_t mask=((2ULL<<(bitsize-1))-1)<<lshift;
+		w=(w & ~mask) | ((val<<lshift) & mask);
+		for(uint32_t i=n;i-->0;)
 		{
-			uint32_t tmp;
-			tmp=(data[bitpos/8] << 16) | (data[bitpos/8+1] << 8) | data[bitpos/8+2];
-			uint32_t mask=(1<<bitsize)-1;
-			int lshift=24-(bitpos&7)-bitsize;
-			tmp=(tmp & ~(mask << lshift)) | (val << lshift);
-			data[bitpos/8] = tmp>>16;
-			data[bitpos/8+1] = tmp>>8;
-			data[bitpos/8+2] = tmp&0xff;
+			data[byte+i]=w;
+			w>>=8;
 		}
 		bitpos+=bitsize;
+		if(bitpos>acc_pos)
+		{
+			uint32_t used=wpos-acc_pos;
+			uint32_t bytes=(used+7)/8;
+			acc=0;
+			for(uint32_t i=0;i<8;i++)
+				acc=(acc<<8)|(i<bytes?data[acc_pos/8+i]:0);
+			acc=used?acc&(~0ULL<<(64-used)):0;
+		}
 	}
-	inline void nocheck_uint(int bitsize, uint32_t val)
+	/**
+	 * \brief Marks bits up to ioCtx.bitpos as written.
+	 * \details Must be called after ioCtx.bitpos is advanced without \ref obCtx::nocheck_bits,
+	 * when field is reserved or bytes are copied directly to obCtx.data.
+	 * Later writes before that position are then done as back-patches and do not overwrite those bytes.
+	 */
+	inline void advance()
+	{
+		if(bitpos>wpos)
+			reseat();
+	}
+private:
+	/**
+	 * Moves obCtx.acc to ioCtx.bitpos after it was advanced without writing (reserved or memcpy'd bits).
+	 */
+	inline void reseat()
 	{
-		if((bitpos&7) + bitsize<=32)
+		acc_pos=bitpos&~7U;
+		wpos=bitpos;
+		acc=0;
+		if((bitpos&7)!=0 && bitpos/8<data_size)
+			acc=(uint64_t)(data[bitpos/8]&(0xff00>>(bitpos&7)))<<56;
+	}
+	/**
+	 * Writes bytes of obCtx.acc up to obCtx.wpos to obCtx.data.
+	 */
+	inline void store()
+	{
+		uint32_t byte=acc_pos/8;
+		uint32_t end=(wpos+7)/8;
+		if(end>data_size)
+			end=data_size;
+		if(byte+8<=end)
 		{
-			//fast route
-			//uint32_t mask=(1<<bitsize)-1;
-			uint32_t mask=(2<<(bitsize-1))-1; //fix for x86 stupid bitshift policy
-			int lshift=32-(bitpos&7)-bitsize;
-			uint32_t tmp=0;
-			tmp=    (data[bitpos/8+0]<<24) | (data[bitpos/8+1]<<16) |
-					(data[bitpos/8+2]<<8)  | (data[bitpos/8+3]);
-			tmp=(tmp & ~(mask << lshift )) | (val << lshift);
-			data[bitpos/8+0] = tmp>>24;
-			data[bitpos/8+1] = tmp>>16;
-			data[bitpos/8+2] = tmp>>8;
-			data[bitpos/8+3] = tmp>>0;
-			bitpos+=bitsize;
+			store_be64(data+byte,acc);
+		}
+		else
+		{
+			for(uint32_t i=byte;i<end;i++)
+				data[i]=acc>>(56-8*(i-byte));
 		}
 	}
 };
@@ -304,18 +606,173 @@ struct ocScope
 	uint32_t bitlimit_at_enter;
 	uint32_t position_for_write;
 };
+/**
+ * \brief Receiver of constructed text
+ * \param sink_ctx - context given together with sink
+ * \param text - chunk of text
+ * \param len - length of chunk
+ * \details See \ref iox::construct_text(text_sink,void*,uint32_t).
+ */
+typedef void (*text_sink)(void* sink_ctx, const char* text, size_t len);
+/**
+ * \brief Text sink writing to file descriptor
+ * \details \b sink_ctx is file descriptor cast to pointer: (void*)(intptr_t)fd.
+ */
+void text_sink_fd(void* sink_ctx, const char* text, size_t len);
+/**
+ * \brief Text sink writing to stdio stream
+ * \details \b sink_ctx is FILE*.
+ */
+void text_sink_file(void* sink_ctx, const char* text, size_t len);
+
+/*!
+ * \def MOPA_TEXT_CHUNK
+ * Default amount of text collected before it is passed to \ref text_sink.
+ */
+#ifndef MOPA_TEXT_CHUNK
+#define MOPA_TEXT_CHUNK 65536
+#endif
+
+/*!
+ * \def MOPA_TEXT_LINES
+ * Size of buffer where lines inside blocks are formatted before they go to ocCtx::prod.
+ */
+#ifndef MOPA_TEXT_LINES
+#define MOPA_TEXT_LINES 8192
+#endif
+
+/**
+ * \brief Text waiting to be inserted into ocCtx::prod
+ */
+struct ocInsertion
+{
+	uint32_t position;	/**< offset in ocCtx::prod where text goes */
+	uint32_t offset;	/**< offset of text in ocCtx::inserted */
+	uint32_t length;	/**< length of text */
+};
+/**
+ * \brief Context for text output mode
+ */
 class ocCtx : public oCtx
 {
 public:
-	std::vector<ocScope> scope_stack;
+	inline_stack<ocScope> scope_stack;
+	/**
+	 * \brief Constructed text.
+	 * \details Lengths of named blocks are known only when block ends, but are printed before it.
+	 * They are kept in ocCtx::insertions and merged into text in one pass when outermost block ends,
+	 * so while blocks are open (or after error) text lacks lengths of closed named blocks.
+	 * Lines inside blocks are collected in ocCtx::lines first, so it also lacks some recent lines.
+	 */
 	std::string prod;
+	/**
+	 * \brief Lines formatted inside blocks, not yet appended to ocCtx::prod.
+	 * \details Buffer keeps MOPA_TEXT_LINES characters, first ocCtx::lines_len of them are used.
+	 * It is appended to ocCtx::prod at once when it fills up and when outermost block ends.
+	 */
+	std::string lines;
+	uint32_t lines_len;
+	/**
+	 * \brief Pending insertions into ocCtx::prod.
+	 */
+	std::vector<ocInsertion> insertions;
+	/**
+	 * \brief Storage for text of pending insertions.
+	 */
+	std::string inserted;
+	/**
+	 * \brief Receiver of text, NULL if text is only collected in ocCtx::prod.
+	 */
+	text_sink sink;
+	void* sink_ctx;
+	/**
+	 * \brief Amount of text in ocCtx::prod that is passed to ocCtx::sink at once.
+	 */
+	uint32_t chunk_size;
+	/**
+	 * \brief Pass collected text to ocCtx::sink
+	 * \details Text can be passed only outside of blocks, as lengths of blocks are inserted before them.
+	 * Inside block, or when there is no sink, nothing happens.
+	 * Binary position restarts, only alignment within byte is kept.
+	 */
+	void flush();
+	/**
+	 * \brief Flush if chunk is full
+	 */
+	inline void chunk_done()
+	{
+		if(sink!=NULL && prod.size()>=chunk_size && scope_stack.size()==0)
+			flush();
+	}
+	/**
+	 * \brief Append indentation of current depth to ocCtx::prod
+	 */
+	inline void indent()
+	{
+		prod.append(scope_stack.size()*2,' ');
+	}
+	/**
+	 * \brief Offset in complete text where next line goes
+	 */
+	inline uint32_t text_size() const
+	{
+		return prod.size()+lines_len;
+	}
+	/**
+	 * \brief Append ocCtx::lines to ocCtx::prod
+	 */
+	inline void commit_lines()
+	{
+		if(lines_len==0)
+			return;
+		prod.append(lines.data(),lines_len);
+		lines_len=0;
+	}
+	/**
+	 * \brief Space for line of at most \b len characters in ocCtx::lines
+	 * \details Caller writes line there and adds its length to ocCtx::lines_len.
+	 * \return where line goes, or NULL if it goes directly to ocCtx::prod,
+	 * which is outside blocks or when line does not fit in buffer
+	 */
+	inline char* line_space(size_t len)
+	{
+		if(scope_stack.size()==0 || len>lines.size())
+		{
+			commit_lines();
+			return NULL;
+		}
+		if(lines_len+len>lines.size())
+			commit_lines();
+		return &lines[lines_len];
+	}
 	void enter_scope(const iox_info* info=NULL);
 	void leave_scope(const iox_info* info=NULL);
-	void write_uint(int bitsize, uint32_t value, const iox_info* info=NULL);
+	void write_uint(int bitsize, uint64_t value, const iox_info* info=NULL);
+	/**
+	 * \brief Schedule integer line for insertion
+	 * \param position - offset in ocCtx::prod where line goes
+	 * \param depth - block depth, determines indentation
+	 * \param bitsize - size of integer
+	 * \param value - value of integer
+	 * \param info - name and format of integer
+	 */
+	void insert_uint(uint32_t position, uint32_t depth, int bitsize, uint64_t value, const iox_info* info=NULL);
+	/**
+	 * \brief Apply pending insertions to ocCtx::prod
+	 * \details Called when outermost block ends. Linear in size of text.
+	 */
+	void merge_insertions();
 private:
-	void write_hex(int bitsize,uint32_t value);
-	void write_bin(int bitsize,uint32_t value);
-	void write_dec(int bitsize,uint32_t value);
+	void format_uint(std::string& out, uint32_t depth, int bitsize, uint64_t value, const iox_info* info);
+	/**
+	 * Formats integer line to \b p, returns position after it. Value is already checked against \b bitsize.
+	 * \b p must hold depth*2+name_len+68 characters.
+	 */
+	char* format_line(char* p, uint32_t depth, int bitsize, uint64_t value, const iox_info* info, size_t name_len);
+	/** Formats value to \b buf, returns number of characters. \b buf must hold 66 characters. */
+	static int write_hex(char* buf,int bitsize,uint64_t value);
+	static int write_bin(char* buf,int bitsize,uint64_t value);
+	static int write_dec(char* buf,int bitsize,uint64_t value);
 };
 
 
@@ -325,59 +782,118 @@ struct ibScope
 	uint32_t bitpos_at_enter;
 	uint32_t bitlimit_at_enter;
 };
+/**
+ * \brief Context for binary input mode
+ */
 class ibCtx : public iCtx
 {
 public:
+	/**
+	 * \brief Parsed bitstream.
+	 * \details This field is filled by iox::parse_binary. It must not been changed.
+	 */
 	const uint8_t *data;
-	std::vector<ibScope> scope_stack;
-	inline uint8_t nocheck_uint8(int bitsize)
+	/**
+	 * \brief Size of ibCtx.data in bytes.
+	 * \details Cache refills never read beyond it, regardless of ioCtx.bitlimit.
+	 */
+	uint32_t data_size;
+	inline_stack<ibScope> scope_stack;
+	/**
+	 * \brief Cached bitstream word.
+	 * \details Holds 64 bits of ibCtx.data starting at ibCtx.cache_pos, most significant bit first.
+	 * Consecutive fields are served from it by shift and mask only.
+	 */
+	uint64_t cache;
+	/**
+	 * \brief Position of first bit held in ibCtx.cache. It is always byte-aligned.
+	 */
+	uint32_t cache_pos;
+	/**
+	 * \brief Loads ibCtx.cache from byte containing ioCtx.bitpos.
+	 * \details
+	 * In most cases this is one unaligned 8-byte load. Close to end of ibCtx.data
+	 * remaining bytes are assembled one by one and missing ones are read as 0.
+	 */
+	inline void refill()
 	{
-		uint8_t val;
-		if((bitpos&7) + bitsize<=8)
+		cache_pos=bitpos&~7U;
+		uint32_t byte=cache_pos/8;
+		if(byte+8<=data_size)
 		{
-			//fast route
-			val=((data[bitpos/8]<<(bitpos&7)) & 0xff) >>(8-bitsize);
+			cache=load_be64(data+byte);
 		}
 		else
 		{
-			val=((( (data[bitpos/8] << 8) | data[(bitpos/8)+1] ) << (bitpos & 7)) & 0xffff) >> (16-bitsize);
+			cache=0;
+			for(uint32_t i=byte;i<byte+8;i++)
+				cache=(cache<<8)|(i<data_size?data[i]:0);
 		}
-		bitpos+=bitsize;
-		return val;
 	}
-	inline uint16_t nocheck_uint16(int bitsize)
+	/**
+	 * \brief Gets integer from bitstream.
+	 * \details
+	 * Function reads \b bitsize bits at ioCtx.bitpos and moves ioCtx.bitpos after them.
+	 * Value is cut out of ibCtx.cache, which is reloaded only if requested bits are not inside it.
+	 * After reload at least 57 bits are available, so \b bitsize must be in range 1..57.\n
+	 * Any change to ioCtx.bitpos done outside this function is handled, as cache is validated against ioCtx.bitpos.\n
+	 * Function does not perform any range-checks. It is error to read if ioCtx.bitpos+<b>bitsize</b>>ioCtx.bitlimit.
+	 */
+	inline uint64_t nocheck_bits(int bitsize)
 	{
-		uint16_t val;
-		if((bitpos&7) + bitsize<=16)
+		uint32_t off=bitpos-cache_pos;
+		if(off>(uint32_t)(64-bitsize))
 		{
-			//fast route
-			uint16_t tmp;
-			tmp=(data[bitpos/8]<<8) | data[bitpos/8+1];
-			val=((tmp<<(bitpos&7)) & 0xffff)>>(16-bitsize);
-		}
-		else
-		{
-			uint32_t tmp;
-			tmp=(data[bitpos/8]<<16) | (data[bitpos/8+1]<<8) | data[bitpos/8+2];
-			val=((tmp << (bitpos & 7)) & 0xffffff) >> (24-bitsize);
+			refill();
+			off=bitpos&7;
 		}
+		uint64_t val=(cache<<off)>>(64-bitsize);
 		bitpos+=bitsize;
 		return val;
-
+	}
+	/**
+	 * \brief Gets integer from bitstream.
+	 * \details See \ref ibCtx::nocheck_bits.
+	 * \note There are uint8_t, uint16_t, uint32_t and uint64_t variants.
+	 */
+	inline uint8_t nocheck_uint8(int bitsize)
+	{
+		return nocheck_bits(bitsize);
+	}
+	inline uint16_t nocheck_uint16(int bitsize)
+	{
+		return nocheck_bits(bitsize);
 	}
 	inline uint32_t nocheck_uint32(int bitsize)
 	{
-		uint32_t val=0;
-		if((bitpos&7) + bitsize<=32)
+		return nocheck_bits(bitsize);
+	}
+	/**
+	 * \brief Gets integer from bitstream.
+	 * \details Fields up to 57 bits are read with single \ref ibCtx::nocheck_bits, longer ones are split in two.
+	 */
+	inline uint64_t nocheck_uint64(int bitsize)
+	{
+		if(bitsize<=57)
+			return nocheck_bits(bitsize);
+		uint64_t hi=nocheck_bits(bitsize-32);
+		return (hi<<32)|nocheck_bits(32);
+	}
+	/**
+	 * \brief Gets integer of compile-time width from bitstream.
+	 * \details Choice between single and split read is made at compile time,
+	 * and all shifts of \ref ibCtx::nocheck_bits become constants once inlined.
+	 */
+	template<int BITS>
+	inline uint64_t nocheck_bits()
+	{
+		if constexpr(BITS>57)
 		{
-			//fast route
-			uint32_t tmp;
-			tmp=    (data[bitpos/8+0]<<24) | (data[bitpos/8+1]<<16) |
-					(data[bitpos/8+2]<<8)  | (data[bitpos/8+3]);
-			val=tmp<<(bitpos&7)>>(32-bitsize);
-			bitpos+=bitsize;
+			uint64_t hi=nocheck_bits<BITS-32>();
+			return (hi<<32)|nocheck_bits<32>();
 		}
-		return val;
+		else
+			return nocheck_bits(BITS);
 	}
 };
 
@@ -388,21 +904,71 @@ struct icScope
 	uint32_t bitpos_at_enter;
 	uint32_t bitlimit_at_enter;
 };
+/*!
+ * \def MOPA_TEXT_PARSE_BITLIMIT
+ * Limit of binary size, in bits, that parsed text may represent.
+ */
+#ifndef MOPA_TEXT_PARSE_BITLIMIT
+#define MOPA_TEXT_PARSE_BITLIMIT 0xffffff00U
+#endif
+
+/**
+ * \brief Context for text input mode
+ */
 class icCtx : public iCtx
 {
 public:
-	std::vector<icScope> scope_stack;
+	inline_stack<icScope> scope_stack;
 	const char* parsed_text;
 	const char* parse_pos;
+	/**
+	 * \brief End of parsed text.
+	 * \details Text is never read at or beyond it, so it does not need to be terminated.
+	 */
+	const char* parse_end;
+	/**
+	 * \brief Line of icCtx::parse_pos, counted from 1.
+	 * \details Updated as newlines are consumed, so error location does not require scanning text again.
+	 */
+	uint32_t line_nr;
+	/**
+	 * \brief Beginning of line icCtx::line_nr.
+	 */
+	const char* line_begin;
 	void enter_scope(const iox_info* info=NULL);
 	void leave_scope(const iox_info* info=NULL);
-	uint32_t read_uint(int bitsize,  const iox_info* info=NULL);
+	uint64_t read_uint(int bitsize,  const iox_info* info=NULL);
 	bool expect(const char* req);
 	bool skiptotoken();
+	/**
+	 * \brief Take next character
+	 * \return character at icCtx::parse_pos, or 0 at end of text
+	 */
+	inline uint8_t next_char()
+	{
+		if(parse_pos>=parse_end)
+			return 0;
+		uint8_t c=*parse_pos++;
+		if(c=='\n')
+		{
+			line_nr++;
+			line_begin=parse_pos;
+		}
+		return c;
+	}
+	/**
+	 * \brief Look at character
+	 * \return character at icCtx::parse_pos+ahead, or 0 beyond end of text
+	 */
+	inline uint8_t peek(uint32_t ahead=0) const
+	{
+		return parse_end-parse_pos>ahead?parse_pos[ahead]:0;
+	}
 private:
-	uint32_t read_hex(int bitsize,const iox_info* info);
-	uint32_t read_bin(int bitsize,const iox_info* info);
-	uint32_t read_dec(int bitsize,const iox_info* info);
+	void count_lines(const char* p, uint32_t newline_mask);
+	uint64_t read_hex(int bitsize,const iox_info* info);
+	uint64_t read_bin(int bitsize,const iox_info* info);
+	uint64_t read_dec(int bitsize,const iox_info* info);
 
 };
 
@@ -411,6 +977,42 @@ private:
  */
 
 
+/**
+ * \brief Exception thrown on error
+ *
+ * Field 'message' contains formatted textual representation of error that has occurred.
+ * Field 'error' holds the same in compact form.
+ */
+class Exception
+{
+public:
+	/**
+	 * \param x - context of I/O operation
+	 * \param info - location of operation that faulted
+	 * \param code - class of error
+	 * \param fmt - format string literal, as for printf, only with d, i, u, x, o, c and s conversions
+	 * \param ... - parameters for fmt
+	 *
+	 * If ioCtx::nothrow is set, \b message is left empty and fmt is formatted only by io_error::message.
+	 */
+	Exception(
+			const ioCtx* x,
+			const iox_info* info,
+			error_code code,
+			const char* fmt, ...);
+	/** \brief Same as above, with code ERR_OTHER */
+	Exception(
+			const ioCtx* x,
+			const iox_info* info,
+			const char* fmt, ...);
+	/** \brief Wrap recorded error, \b message is formatted from it */
+	explicit Exception(const io_error& error);
+	std::string message;
+	io_error error;
+private:
+	void record(const ioCtx* x, const iox_info* info, error_code code, const char* fmt, va_list args);
+};
+
 /**
  * \addtogroup IOX Classes for fundamental IO.
  * \{
@@ -420,41 +1022,178 @@ private:
  * \brief Top-level class for Input/Output operations
  *
  * It is used as context for I/O operations.
+ * Context is held inside iox object, so creating iox does not allocate memory.
+ * iox can be moved, but not copied. Once created, it can be bound to next data with \ref reset:
+ * \code
+ * iox x;
+ * while(next_section(&data,&size))
+ * {
+ *	x.reset(data,size);
+ *	section.io(x);
+ * }
+ * \endcode
  */
 class iox
 {
 public:
+	/**
+	 * \brief Create iox object for binary parsing of empty data
+	 * \details Data is expected to be provided later with \ref reset.
+	 */
+	iox();
 	~iox();
-	iox(iox const &from);
-	iox& operator=(iox const &rhs);
+	iox(iox const &from)=delete;
+	iox& operator=(iox const &rhs)=delete;
+	/**
+	 * \brief Move iox object
+	 * \details Context, including its scope stack, is moved into this object.
+	 * \b from stays valid, but its state is unspecified.
+	 */
+	iox(iox&& from);
+	iox& operator=(iox&& rhs);
+	/**
+	 * \brief Create iox object for binary parsing mode
+	 *
+	 * \param data - binary data for parsing
+	 * \param size - size (in bytes) of data to be parsed
+	 * \retval iox object
+	 */
+	static iox parse_binary(const uint8_t* data, uint32_t size);
+	/**
+	 * \brief Create iox object for parsing textual representation
+	 *
+	 * \param text - c string containing text to parse
+	 * \retval iox object
+	 */
+	static iox parse_text(const char* text);
+	/**
+	 * \brief Create iox object for parsing textual representation of given length
+	 *
+	 * \param text - text to parse, does not need to be terminated, can be mmap'ed file
+	 * \param len - length of text
+	 * \retval iox object
+	 */
+	static iox parse_text(const char* text, size_t len);
+	/**
+	 * \brief Create iox object for binary construction mode
+	 *
+	 * \param data - buffer to write constructed data
+	 * \param size - size (in bytes) of buffer
+	 * \retval iox object
+	 */
+	static iox construct_binary(uint8_t* data, uint32_t size);
+	/**
+	 * \brief Create iox object for constructing textual representation
+	 * \retval iox object
+	 */
+	static iox construct_text();
+	/**
+	 * \brief Create iox object for constructing textual representation into sink
+	 * \param sink - receiver of text
+	 * \param sink_ctx - context passed to \b sink
+	 * \param chunk_size - amount of text collected before it is passed to \b sink
+	 * \retval iox object
+	 *
+	 * Text is passed to sink whenever outermost block ends and at least \b chunk_size bytes were collected,
+	 * so memory used is bounded by chunk_size and size of largest top-level block, not by whole output.
+	 * Binary position restarts (keeping bit alignment) when outermost block ends or text is flushed,
+	 * so size limit applies to each top-level block, not to whole stream.
+	 * Remaining text is passed on reset or destruction, or with explicit ocCtx::flush:
+	 * \code
+	 * iox x=iox::construct_text(text_sink_file,stdout);
+	 * for(...)
+	 *	section.io(x);
+	 * \endcode
+	 */
+	static iox construct_text(text_sink sink, void* sink_ctx, uint32_t chunk_size=MOPA_TEXT_CHUNK);
+	/**
+	 * \brief Create iox object for validation of binary data
+	 *
+	 * \param data - binary data to validate
+	 * \param size - size (in bytes) of data
+	 * \retval iox object
+	 *
+	 * Validation is binary parsing that checks everything parsing does and throws the same exceptions,
+	 * but does not keep any content: vectors stay untouched, descriptors are not allocated and strings are not copied.
+	 * Integer fields are still set, because io() may depend on their values. See \ref ivx.
+	 */
+	static iox validate_binary(const uint8_t* data, uint32_t size);
+	/**
+	 * \brief Create iox object for measuring size of binary construction
+	 *
+	 * \param size - maximum size (in bytes) accepted, as size of buffer for \ref construct_binary
+	 * \retval iox object
+	 *
+	 * Measuring is binary construction that checks everything construction does and throws the same exceptions,
+	 * but does not write anything. After io() ioCtx::bitpos is exact length of constructed bitstream,
+	 * including lengths of blocks and CRC:
+	 * \code
+	 * iox m=iox::measure_binary();
+	 * nit.io(m);
+	 * std::vector<uint8_t> buf(m.ctx->bitpos/8);
+	 * iox x=iox::construct_binary(buf.data(),buf.size());
+	 * nit.io(x);
+	 * \endcode
+	 * See \ref omx.
+	 */
+	static iox measure_binary(uint32_t size=0x1000000);
+	/**
+	 * \brief Rebind iox object to new binary data
+	 *
+	 * \param data - binary data for parsing
+	 * \param size - size (in bytes) of data
+	 *
+	 * Switches to binary parsing mode and starts from first bit of \b data.
+	 * Memory already owned by context is reused, so after first use reset does not allocate.
+	 */
+	void reset(const uint8_t* data, uint32_t size);
+	/**
+	 * \brief Rebind iox object to new buffer
+	 *
+	 * \param data - buffer to write constructed data
+	 * \param size - size (in bytes) of buffer
+	 *
+	 * Switches to binary construction mode, see \ref reset(const uint8_t*,uint32_t).
+	 */
+	void reset_construct(uint8_t* data, uint32_t size);
+	/**
+	 * \brief Rebind iox object to new text
+	 *
+	 * \param text - c string containing text to parse
+	 *
+	 * Switches to text parsing mode, see \ref reset(const uint8_t*,uint32_t).
+	 */
+	void reset(const char* text);
 	/**
-	 * \brief Create iox object for binary parsing mode
+	 * \brief Rebind iox object to new text of given length
 	 *
-	 * \param data - binary data for parsing
-	 * \param size - size (in bytes) of data to be parsed
-	 * \retval iox object
+	 * See \ref parse_text(const char*,size_t).
 	 */
-	static iox parse_binary(const uint8_t* data, uint32_t size);
+	void reset(const char* text, size_t len);
 	/**
-	 * \brief Create iox object for parsing textual representation
+	 * \brief Restart construction of text
 	 *
-	 * \param text - c string containing text to parse
-	 * \retval iox object
+	 * Switches to text construction mode and clears produced text, keeping its storage.
 	 */
-	static iox parse_text(const char* text);
+	void reset_construct_text();
 	/**
-	 * \brief Create iox object for binary construction mode
+	 * \brief Restart construction of text into sink
 	 *
-	 * \param data - buffer to write constructed data
-	 * \param size - size (in bytes) of buffer
-	 * \retval iox object
+	 * Text collected for previous sink is passed to it, see \ref construct_text(text_sink,void*,uint32_t).
 	 */
-	static iox construct_binary(uint8_t* data, uint32_t size);
+	void reset_construct_text(text_sink sink, void* sink_ctx, uint32_t chunk_size=MOPA_TEXT_CHUNK);
 	/**
-	 * \brief Create iox object for constructing textual representation
-	 * \retval iox object
+	 * \brief Rebind iox object to new binary data for validation
+	 *
+	 * Switches to validation mode, see \ref reset(const uint8_t*,uint32_t).
 	 */
-	static iox construct_text();
+	void reset_validate(const uint8_t* data, uint32_t size);
+	/**
+	 * \brief Restart measuring
+	 *
+	 * Switches to measure mode, see \ref measure_binary.
+	 */
+	void reset_measure(uint32_t size=0x1000000);
 
 	ix as_ix();
 	ox as_ox();
@@ -462,6 +1201,13 @@ public:
 	icx as_icx();
 	obx as_obx();
 	ocx as_ocx();
+	/**
+	 * \brief Projection parse of binary data, see \ref ipx
+	 * \param keep_depth - blocks nested at least this deep are skipped
+	 */
+	ipx as_ipx(uint32_t keep_depth=1);
+	ivx as_ivx();
+	omx as_omx();
 	void uint(int bitsize, uint8_t&  val, const iox_info* info=NULL);
 	void uint(int bitsize, uint16_t& val, const iox_info* info=NULL);
 	/**
@@ -481,10 +1227,11 @@ public:
 	 * | construct binary | obx::uint |
 	 * | construct text | ocx::uint |
 	 *
-	 * There are \b uint32_t, \b uint16_t and \b uint8_t variants or this method.
+	 * There are \b uint64_t, \b uint32_t, \b uint16_t and \b uint8_t variants or this method.
 	 * \throws mopa::Exception
 	 */
 	void uint(int bitsize, uint32_t& val, const iox_info* info=NULL);
+	void uint(int bitsize, uint64_t& val, const iox_info* info=NULL);
 	void uint_req(int bitsize, uint8_t val, const iox_info* info=NULL);
 	void uint_req(int bitsize, uint16_t val, const iox_info* info=NULL);
 	/**
@@ -507,12 +1254,42 @@ public:
 	 * | construct binary | obx::uint |
 	 * | construct text | ocx::uint |
 	 *
-	 * There are \b uint32_t, \b uint16_t and \b uint8_t variants or this method.
+	 * There are \b uint64_t, \b uint32_t, \b uint16_t and \b uint8_t variants or this method.
 	 * In addition \b int version is added for convenience. It redirects to specific cases based on \b bitsize.
 	 * \throws mopa::Exception
 	 */
 	void uint_req(int bitsize, uint32_t val, const iox_info* info=NULL);
+	void uint_req(int bitsize, uint64_t val, const iox_info* info=NULL);
 	void uint_req(int bitsize, int val, const iox_info* info=NULL);
+	/**
+	 * \brief Declares integer value of compile-time width
+	 *
+	 * \tparam BITS - number of bits to read/write, 1..64
+	 * \param var - variable to fill/variable to provide value
+	 * \param info - location of operation
+	 *
+	 * Same as \ref iox::uint, but \b BITS must fit in type of \b var, which is checked at compile time.
+	 * When io() is instantiated for \ref ibx, \ref obx, \ref icx or \ref ocx
+	 * masks and shifts are constants and the call is inlined:
+	 * \code
+	 * x.template uint<12>(DVB_VAR(section_length));
+	 * \endcode
+	 * \throws mopa::Exception
+	 */
+	template<int BITS,class T>
+	void uint(T& var, const iox_info* info=NULL);
+	/**
+	 * \brief Require a specific value of compile-time width
+	 *
+	 * \tparam BITS - number of bits to read/write, 1..64
+	 * \tparam VAL - required value, must fit in \b BITS, which is checked at compile time
+	 * \param info - location of operation
+	 *
+	 * Same as \ref iox::uint_req.
+	 * \throws mopa::Exception
+	 */
+	template<int BITS,uint64_t VAL>
+	void uint_req(const iox_info* info=NULL);
 	/**
 	 * \brief Begin block declared by variable
 	 *
@@ -592,11 +1369,34 @@ public:
 	 * \return true if in either parsing or constructing binary, false otherwise
 	 */
 	inline bool is_binary(){return ctx->is_binary();}
+	/**
+	 * \brief Checks if current mode is validation
+	 * \return true if validating binary data, see \ref validate_binary
+	 */
+	inline bool is_validating(){return ctx->is_validating();}
+	/**
+	 * \brief Checks if current mode is measuring
+	 * \return true if measuring size of binary construction, see \ref measure_binary
+	 */
+	inline bool is_measuring(){return ctx->is_measuring();}
 
 	ioCtx* ctx;
 private:
-	iox();
-	iox(ioCtx* ctx);
+	void create(bool parsing, bool binary);
+	void move_from(iox& from);
+	void destroy();
+	/**
+	 * Storage for context of current mode. \ref ctx points to active member.
+	 */
+	union storage
+	{
+		storage(){}
+		~storage(){}
+		ibCtx ib;
+		icCtx ic;
+		obCtx ob;
+		ocCtx oc;
+	} store;
 };
 
 /** \brief Input class, aggregates both binary and text */
@@ -613,9 +1413,10 @@ public:
 	 * \param bitsize - size of integer
 	 * \param info - location of operation
 	 * \return value read
-	 * \note uint32_t, uint16_t and uint8_t versions exist
+	 * \note uint64_t, uint32_t, uint16_t and uint8_t versions exist
 	 */
 	uint32_t uint32(int bitsize, const iox_info* info=NULL);
+	uint64_t uint64(int bitsize, const iox_info* info=NULL);
 	/** \brief see \ref iox::named_block_begin */
 	void named_block_begin(int bitsize,const iox_info* info=NULL);
 	/** \brief see \ref iox::named_block_end */
@@ -632,6 +1433,7 @@ public:
 	ox(oCtx* x);
 	obx as_obx();
 	ocx as_ocx();
+	omx as_omx();
 	void uint(int bitsize, uint8_t val,  const iox_info* info=NULL);
 	void uint(int bitsize, uint16_t val, const iox_info* info=NULL);
 	/**
@@ -639,9 +1441,10 @@ public:
 	 * \param bitsize - size of integer
 	 * \param val - value to write
 	 * \param info - location of operation
-	 * \note uint32_t, uint16_t and uint8_t versions exist
+	 * \note uint64_t, uint32_t, uint16_t and uint8_t versions exist
 	 */
 	void uint(int bitsize, uint32_t val, const iox_info* info=NULL);
+	void uint(int bitsize, uint64_t val, const iox_info* info=NULL);
 	/** \brief see \ref iox::named_block_begin */
 	void named_block_begin(int bitsize,const iox_info* info=NULL);
 	/** \brief see \ref iox::named_block_end */
@@ -651,22 +1454,62 @@ public:
 private:
 	oCtx* ctx;
 };
-/** \brief Binary Input class */
+/**
+ * \brief Binary Input class
+ *
+ * Besides its own specialized methods, it implements the same interface as \ref iox
+ * (uint, uint_req, named_block_begin, named_block_end, block_size_left, is_parsing, is_binary).
+ * Therefore it can be used to instantiate template io() of syntactic structures:
+ * \code
+ * template<class X> void io(X& x)
+ * {
+ *	x.uint(8,DVB_VAR(descriptor_tag));
+ *	...
+ * }
+ * \endcode
+ * Mode checks are then resolved at compile time and field reads are inlined down to \ref ibCtx::nocheck_bits.
+ * Same applies to \ref obx, \ref icx and \ref ocx.
+ */
 class ibx
 {
 public:
-	ibx(ibCtx* x);
-	iox as_iox();
-	uint8_t  uint8 (int bitsize, const iox_info* info=NULL);
-	uint16_t uint16(int bitsize, const iox_info* info=NULL);
+	inline ibx(ibCtx* x):ctx(x){}
+	/** \brief Always true, see \ref iox::is_parsing */
+	static bool is_parsing(){return true;}
+	/** \brief Always true, see \ref iox::is_binary */
+	static bool is_binary(){return true;}
+	/** \brief Always false, see \ref iox::is_validating */
+	static bool is_validating(){return false;}
+	/** \brief Always false, see \ref iox::is_measuring */
+	static bool is_measuring(){return false;}
+	inline uint8_t  uint8 (int bitsize, const iox_info* info=NULL);
+	inline uint16_t uint16(int bitsize, const iox_info* info=NULL);
 	/**
 	 * \brief Read integer
 	 * \param bitsize - size of integer
 	 * \param info - location of operation
 	 * \return value read
-	 * \note uint32_t, uint16_t and uint8_t versions exist
+	 * \note uint64_t, uint32_t, uint16_t and uint8_t versions exist
 	 */
-	uint32_t uint32(int bitsize, const iox_info* info=NULL);
+	inline uint32_t uint32(int bitsize, const iox_info* info=NULL);
+	inline uint64_t uint64(int bitsize, const iox_info* info=NULL);
+	void uint(int bitsize, uint8_t&  val, const iox_info* info=NULL){val=uint8(bitsize,info);}
+	void uint(int bitsize, uint16_t& val, const iox_info* info=NULL){val=uint16(bitsize,info);}
+	/** \brief see \ref iox::uint */
+	void uint(int bitsize, uint32_t& val, const iox_info* info=NULL){val=uint32(bitsize,info);}
+	void uint(int bitsize, uint64_t& val, const iox_info* info=NULL){val=uint64(bitsize,info);}
+	/** \brief see \ref iox::uint_req */
+	inline void uint_req(int bitsize, uint64_t val, const iox_info* info=NULL);
+	/** \brief see \ref iox::uint<BITS> */
+	template<int BITS,class T>
+	inline void uint(T& var, const iox_info* info=NULL);
+	/** \brief see \ref iox::uint_req<BITS,VAL> */
+	template<int BITS,uint64_t VAL>
+	inline void uint_req(const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_begin */
+	void named_block_begin(int bitsize,const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_end */
+	uint32_t named_block_end(const iox_info* info=NULL);
 	/**
 	 * \brief Begin block
 	 * \param block_length - length of block in bytes
@@ -684,9 +1527,9 @@ public:
 	uint32_t block_end(const iox_info* info=NULL);
 	/**
 	 * \brief Query remaining bits in block
-	 * \return number of bits left unparsed
+	 * \return number of bits left unparsed, 0 after error in ioCtx::nothrow mode
 	 */
-	uint32_t block_size_left();
+	uint32_t block_size_left(){return ctx->failed?0:ctx->bitlimit - ctx->bitpos;}
 
 	ibCtx* ctx;
 };
@@ -695,9 +1538,17 @@ public:
 class obx
 {
 public:
-	obx(obCtx* x);
-	void uint(int bitsize, uint8_t val,  const iox_info* info=NULL);
-	void uint(int bitsize, uint16_t val, const iox_info* info=NULL);
+	inline obx(obCtx* x):ctx(x){}
+	/** \brief Always false, see \ref iox::is_parsing */
+	static bool is_parsing(){return false;}
+	/** \brief Always true, see \ref iox::is_binary */
+	static bool is_binary(){return true;}
+	/** \brief Always false, see \ref iox::is_validating */
+	static bool is_validating(){return false;}
+	/** \brief Always false, see \ref iox::is_measuring */
+	static bool is_measuring(){return false;}
+	inline void uint(int bitsize, uint8_t val,  const iox_info* info=NULL);
+	inline void uint(int bitsize, uint16_t val, const iox_info* info=NULL);
 	/**
 	 * \brief Write integer
 	 * \param bitsize - size of integer
@@ -706,9 +1557,25 @@ public:
 	 *
 	 * Writes \b bitsize long integer of value \b val to bitstream.
 	 * \exception iox::Exception If there is no space, or value exceeds 2^bitsize.
-	 * \note uint32_t, uint16_t and uint8_t versions exist
+	 * \note uint64_t, uint32_t, uint16_t and uint8_t versions exist
 	 */
-	void uint(int bitsize, uint32_t val, const iox_info* info=NULL);
+	inline void uint(int bitsize, uint32_t val, const iox_info* info=NULL);
+	inline void uint(int bitsize, uint64_t val, const iox_info* info=NULL);
+	/** \brief see \ref iox::uint_req */
+	void uint_req(int bitsize, uint64_t val, const iox_info* info=NULL){uint(bitsize,val,info);}
+	/**
+	 * \brief see \ref iox::uint<BITS>
+	 * \exception iox::Exception If there is no space, or value exceeds 2^BITS.
+	 */
+	template<int BITS,class T>
+	inline void uint(const T& var, const iox_info* info=NULL);
+	/** \brief see \ref iox::uint_req<BITS,VAL> */
+	template<int BITS,uint64_t VAL>
+	inline void uint_req(const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_begin */
+	void named_block_begin(int bitsize,const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_end */
+	uint32_t named_block_end(const iox_info* info=NULL);
 	/**
 	 * \brief Begin block
 	 * \param block_size_limit - maximum available bytes in block
@@ -731,7 +1598,7 @@ public:
 	 * \brief Query remaining bits in block
 	 * \return number of bits that can fit in current block
 	 */
-	uint32_t block_size_left();
+	uint32_t block_size_left(){return ctx->bitlimit - ctx->bitpos;}
 
 	obCtx* ctx;
 };
@@ -740,7 +1607,15 @@ public:
 class icx
 {
 public:
-	icx(icCtx* x);
+	inline icx(icCtx* x):ctx(x){}
+	/** \brief Always true, see \ref iox::is_parsing */
+	static bool is_parsing(){return true;}
+	/** \brief Always false, see \ref iox::is_binary */
+	static bool is_binary(){return false;}
+	/** \brief Always false, see \ref iox::is_validating */
+	static bool is_validating(){return false;}
+	/** \brief Always false, see \ref iox::is_measuring */
+	static bool is_measuring(){return false;}
 	/**
 	 * \brief Read integer
 	 * \param bitsize - size of integer
@@ -754,9 +1629,27 @@ public:
 	 * Value must fit in \b bitsize bits. Name of variable is encoded in info.name .
 	 * Size of actual message is tracked.
 	 * \exception iox::Exception If there is no space, or value exceeds 2^bitsize.
-	 * \note uint32_t, uint16_t and uint8_t versions exist
+	 * \note uint64 variant exists for fields longer then 32 bits
 	 */
 	uint32_t uint(int bitsize,  const iox_info* info=NULL);
+	uint64_t uint64(int bitsize,  const iox_info* info=NULL);
+	void uint(int bitsize, uint8_t&  val, const iox_info* info=NULL){val=uint(bitsize,info);}
+	void uint(int bitsize, uint16_t& val, const iox_info* info=NULL){val=uint(bitsize,info);}
+	/** \brief see \ref iox::uint */
+	void uint(int bitsize, uint32_t& val, const iox_info* info=NULL){val=uint(bitsize,info);}
+	void uint(int bitsize, uint64_t& val, const iox_info* info=NULL){val=uint64(bitsize,info);}
+	/** \brief see \ref iox::uint_req */
+	void uint_req(int bitsize, uint64_t val, const iox_info* info=NULL);
+	/** \brief see \ref iox::uint<BITS> */
+	template<int BITS,class T>
+	void uint(T& var, const iox_info* info=NULL);
+	/** \brief see \ref iox::uint_req<BITS,VAL> */
+	template<int BITS,uint64_t VAL>
+	void uint_req(const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_begin */
+	void named_block_begin(int bitsize,const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_end */
+	uint32_t named_block_end(const iox_info* info=NULL);
 	/**
 	 * \brief Begin block
 	 * \param block_size_limit - maximum available bytes in block
@@ -787,7 +1680,15 @@ public:
 class ocx
 {
 public:
-	ocx(ocCtx* x);
+	inline ocx(ocCtx* x):ctx(x){}
+	/** \brief Always false, see \ref iox::is_parsing */
+	static bool is_parsing(){return false;}
+	/** \brief Always false, see \ref iox::is_binary */
+	static bool is_binary(){return false;}
+	/** \brief Always false, see \ref iox::is_validating */
+	static bool is_validating(){return false;}
+	/** \brief Always false, see \ref iox::is_measuring */
+	static bool is_measuring(){return false;}
 	/**
 	 * \brief Write integer
 	 * \param bitsize - size of integer
@@ -803,9 +1704,20 @@ public:
 	 * Textual representation is not limited in size.
 	 * Size of actual message is tracked.
 	 * \exception iox::Exception If there is no space, or value exceeds 2^bitsize.
-	 * \note uint32_t, uint16_t and uint8_t versions exist
 	 */
-	void uint(int bitsize, uint32_t val,  const iox_info* info=NULL);
+	void uint(int bitsize, uint64_t val,  const iox_info* info=NULL);
+	/** \brief see \ref iox::uint_req */
+	void uint_req(int bitsize, uint64_t val, const iox_info* info=NULL){uint(bitsize,val,info);}
+	/** \brief see \ref iox::uint<BITS> */
+	template<int BITS,class T>
+	void uint(const T& var, const iox_info* info=NULL);
+	/** \brief see \ref iox::uint_req<BITS,VAL> */
+	template<int BITS,uint64_t VAL>
+	void uint_req(const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_begin */
+	void named_block_begin(int bitsize,const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_end */
+	uint32_t named_block_end(const iox_info* info=NULL);
 	/**
 	 * \brief Begin block
 	 * \param block_size_limit - maximum available bytes in block
@@ -830,36 +1742,509 @@ public:
 	 * \brief Query remaining bits in block
 	 * \return number of bits that can fit in current block
 	 */
-	uint32_t block_size_left();
+	uint32_t block_size_left(){return ctx->bitlimit - ctx->bitpos;}
 
 	ocCtx* ctx;
 };
 
 /**
- * \}
+ * \brief Binary Input class for validation
+ *
+ * Reads and checks data exactly as \ref ibx does.
+ * Difference is in \ref is_validating, that tells syntactic structures to skip storing content:
+ * \ref vector_io reuses single item, \ref descriptor_vector decodes into temporary descriptors,
+ * string functions only check lengths.
  */
+class ivx : public ibx
+{
+public:
+	inline ivx(ibCtx* x):ibx(x){}
+	/** \brief Always true, see \ref iox::is_validating */
+	static bool is_validating(){return true;}
+};
+
 /**
- * \brief Exception thrown on error
+ * \brief Binary Input class for projection parse
  *
- * Only relevant field in this exception is 'message' which contains formatted
- * textual representation of error that has occurred.
+ * Parses like \ref ibx, but named blocks nested at least \b keep_depth deep are skipped
+ * as a whole using their length prefix. Inside skipped block nothing is read:
+ * integers are set to 0, strings are emptied and \ref block_size_left returns 0, so loops end at once.
+ * \ref named_block_end still returns length of skipped block.
+ *
+ * With keep_depth=1 whole section header is parsed and all descriptor loops are skipped:
+ * \code
+ * iox x=iox::parse_binary(data,size);
+ * ipx p=x.as_ipx();
+ * network_information_section nit;
+ * nit.io(p);	//table_id, network_id, version_number, section numbers and CRC are set
+ * \endcode
+ * CRC is read, but not verified.
  */
-class Exception
+class ipx
 {
 public:
+	inline ipx(ibCtx* x, uint32_t keep_depth=1):ctx(x),keep_depth(keep_depth),skipping(0),skipped_length(0){}
+	/** \brief Always true, see \ref iox::is_parsing */
+	static bool is_parsing(){return true;}
+	/** \brief Always true, see \ref iox::is_binary */
+	static bool is_binary(){return true;}
+	/** \brief Always false, see \ref iox::is_validating */
+	static bool is_validating(){return false;}
+	/** \brief Always false, see \ref iox::is_measuring */
+	static bool is_measuring(){return false;}
+	/** \return true if inside skipped block */
+	bool is_skipping() const {return skipping!=0;}
+	void uint(int bitsize, uint8_t&  val, const iox_info* info=NULL){if(skipping) val=0; else val=ibx(ctx).uint8(bitsize,info);}
+	void uint(int bitsize, uint16_t& val, const iox_info* info=NULL){if(skipping) val=0; else val=ibx(ctx).uint16(bitsize,info);}
+	/** \brief see \ref iox::uint */
+	void uint(int bitsize, uint32_t& val, const iox_info* info=NULL){if(skipping) val=0; else val=ibx(ctx).uint32(bitsize,info);}
+	void uint(int bitsize, uint64_t& val, const iox_info* info=NULL){if(skipping) val=0; else val=ibx(ctx).uint64(bitsize,info);}
+	/** \brief see \ref iox::uint_req */
+	void uint_req(int bitsize, uint64_t val, const iox_info* info=NULL){if(!skipping) ibx(ctx).uint_req(bitsize,val,info);}
+	/** \brief see \ref iox::uint<BITS> */
+	template<int BITS,class T>
+	void uint(T& var, const iox_info* info=NULL){if(skipping) var=0; else ibx(ctx).uint<BITS>(var,info);}
+	/** \brief see \ref iox::uint_req<BITS,VAL> */
+	template<int BITS,uint64_t VAL>
+	void uint_req(const iox_info* info=NULL){if(!skipping) ibx(ctx).uint_req<BITS,VAL>(info);}
 	/**
-	 * \param x - context of I/O operation
-	 * \param info - location of operation that faulted
-	 * \param fmt - format string, as for printf
-	 * \param ... - parameters for fmt
+	 * \brief Begin block declared by variable
+	 * \details
+	 * Same as \ref ibx::named_block_begin when block is less then \b keep_depth deep.
+	 * Otherwise length is read and whole block is skipped.
 	 */
-	Exception(
-			const ioCtx* x,
-			const iox_info* info,
-			const char* fmt, ...);
-	std::string message;
+	void named_block_begin(int bitsize,const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_end */
+	uint32_t named_block_end(const iox_info* info=NULL);
+	/** \brief see \ref iox::block_size_left */
+	uint32_t block_size_left(){return skipping || ctx->failed?0:ctx->bitlimit - ctx->bitpos;}
+
+	ibCtx* ctx;
+private:
+	uint32_t keep_depth;
+	uint32_t skipping;
+	uint32_t skipped_length;
+};
+
+/**
+ * \brief Binary Output class for measuring
+ *
+ * Checks everything \ref obx does: available space, widths of values, alignment and limits of blocks.
+ * Instead of writing, it only moves ioCtx::bitpos, so obCtx::data is never accessed.
+ * Length fields of blocks and CRC take the same space as in construction,
+ * therefore after io() ioCtx::bitpos is exact size of bitstream \ref obx would produce.
+ */
+class omx
+{
+public:
+	inline omx(obCtx* x):ctx(x){}
+	/** \brief Always false, see \ref iox::is_parsing */
+	static bool is_parsing(){return false;}
+	/** \brief Always true, see \ref iox::is_binary */
+	static bool is_binary(){return true;}
+	/** \brief Always false, see \ref iox::is_validating */
+	static bool is_validating(){return false;}
+	/** \brief Always true, see \ref iox::is_measuring */
+	static bool is_measuring(){return true;}
+	/**
+	 * \brief Account integer
+	 * \param bitsize - size of integer
+	 * \param val - value of integer
+	 * \param info - location of operation
+	 * \exception iox::Exception If there is no space.
+	 */
+	inline void uint(int bitsize, uint64_t val, const iox_info* info=NULL);
+	/** \brief see \ref iox::uint_req */
+	void uint_req(int bitsize, uint64_t val, const iox_info* info=NULL){uint(bitsize,val,info);}
+	/**
+	 * \brief see \ref iox::uint<BITS>
+	 * \exception iox::Exception If there is no space, or value exceeds 2^BITS.
+	 */
+	template<int BITS,class T>
+	inline void uint(const T& var, const iox_info* info=NULL);
+	/** \brief see \ref iox::uint_req<BITS,VAL> */
+	template<int BITS,uint64_t VAL>
+	inline void uint_req(const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_begin */
+	void named_block_begin(int bitsize,const iox_info* info=NULL);
+	/** \brief see \ref iox::named_block_end */
+	uint32_t named_block_end(const iox_info* info=NULL);
+	/** \brief see \ref obx::block_begin */
+	void block_begin(uint32_t block_size_limit, const iox_info* info=NULL){obx(ctx).block_begin(block_size_limit,info);}
+	/** \brief see \ref obx::block_end */
+	uint32_t block_end(const iox_info* info=NULL){return obx(ctx).block_end(info);}
+	/**
+	 * \brief Query remaining bits in block
+	 * \return number of bits that can fit in current block
+	 */
+	uint32_t block_size_left(){return ctx->bitlimit - ctx->bitpos;}
+
+	obCtx* ctx;
+};
+
+/**
+ * \}
+ */
+
+uint8_t ibx::uint8(int bitsize,const iox_info* info)
+{
+	if(ctx->bitpos + bitsize > ctx->bitlimit)
+	{
+		ctx->fail(info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+		return 0;
+	}
+	return ctx->nocheck_uint8(bitsize);
+}
+uint16_t ibx::uint16(int bitsize,const iox_info* info)
+{
+	if(ctx->bitpos + bitsize > ctx->bitlimit)
+	{
+		ctx->fail(info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+		return 0;
+	}
+	return ctx->nocheck_uint16(bitsize);
+}
+uint32_t ibx::uint32(int bitsize,const iox_info* info)
+{
+	if(ctx->bitpos + bitsize > ctx->bitlimit)
+	{
+		ctx->fail(info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+		return 0;
+	}
+	return ctx->nocheck_uint32(bitsize);
+}
+uint64_t ibx::uint64(int bitsize,const iox_info* info)
+{
+	if(ctx->bitpos + bitsize > ctx->bitlimit)
+	{
+		ctx->fail(info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+		return 0;
+	}
+	return ctx->nocheck_uint64(bitsize);
+}
+void ibx::uint_req(int bitsize,uint64_t val,const iox_info* info)
+{
+	uint64_t v=uint64(bitsize,info);
+	if(v!=val)
+		ctx->fail(info,ERR_VALUE,"%llu read %llu required",(unsigned long long)v,(unsigned long long)val);
+}
+
+void obx::uint(int bitsize,uint8_t val,const iox_info* info)
+{
+	if(ctx->bitpos + bitsize > ctx->bitlimit)
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+	ctx->nocheck_uint(bitsize,val);
+}
+void obx::uint(int bitsize,uint16_t val,const iox_info* info)
+{
+	if(ctx->bitpos + bitsize > ctx->bitlimit)
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+	ctx->nocheck_uint(bitsize,val);
+}
+void obx::uint(int bitsize,uint32_t val,const iox_info* info)
+{
+	if(ctx->bitpos + bitsize > ctx->bitlimit)
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+	ctx->nocheck_uint(bitsize,val);
+}
+void obx::uint(int bitsize,uint64_t val,const iox_info* info)
+{
+	if(ctx->bitpos + bitsize > ctx->bitlimit)
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+	ctx->nocheck_uint(bitsize,val);
+}
+void omx::uint(int bitsize,uint64_t,const iox_info* info)
+{
+	if(ctx->bitpos + bitsize > ctx->bitlimit)
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+	ctx->bitpos+=bitsize;
+}
+
+/**
+ * \brief Compile-time properties of integer field declared with uint<BITS>.
+ * \details Using \b mask instantiates static checks of width against type of variable.
+ */
+template<int BITS,class T>
+struct uint_field
+{
+	static_assert(BITS>=1 && BITS<=64,"field width must be in range 1..64");
+	static_assert(std::is_unsigned<T>::value,"field variable must be unsigned integer");
+	static_assert(BITS<=8*(int)sizeof(T),"field width exceeds size of variable");
+	/** Largest value that fits in field. */
+	static constexpr uint64_t mask=BITS<64?(1ULL<<(BITS%64))-1:~0ULL;
+};
+
+template<int BITS,class T>
+void ibx::uint(T& var,const iox_info* info)
+{
+	(void)uint_field<BITS,T>::mask;
+	if(ctx->bitpos + BITS > ctx->bitlimit)
+	{
+		ctx->fail(info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, BITS);
+		var=0;
+		return;
+	}
+	var=ctx->nocheck_bits<BITS>();
+}
+template<int BITS,uint64_t VAL>
+void ibx::uint_req(const iox_info* info)
+{
+	static_assert(VAL<=uint_field<BITS,uint64_t>::mask,"required value exceeds field width");
+	uint64_t v;
+	uint<BITS>(v,info);
+	if(v!=VAL)
+		ctx->fail(info,ERR_VALUE,"%llu read %llu required",(unsigned long long)v,(unsigned long long)VAL);
+}
+
+template<int BITS,class T>
+void obx::uint(const T& var,const iox_info* info)
+{
+	if(ctx->bitpos + BITS > ctx->bitlimit)
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, BITS);
+	if((uint64_t)var>uint_field<BITS,T>::mask)
+		throw Exception(ctx,info,ERR_VALUE,"value %llu exceeds %d bits",(unsigned long long)var,BITS);
+	ctx->nocheck_bits<BITS>(var);
+}
+template<int BITS,uint64_t VAL>
+void obx::uint_req(const iox_info* info)
+{
+	static_assert(VAL<=uint_field<BITS,uint64_t>::mask,"required value exceeds field width");
+	if(ctx->bitpos + BITS > ctx->bitlimit)
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, BITS);
+	ctx->nocheck_bits<BITS>(VAL);
+}
+
+template<int BITS,class T>
+void omx::uint(const T& var,const iox_info* info)
+{
+	if(ctx->bitpos + BITS > ctx->bitlimit)
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, BITS);
+	if((uint64_t)var>uint_field<BITS,T>::mask)
+		throw Exception(ctx,info,ERR_VALUE,"value %llu exceeds %d bits",(unsigned long long)var,BITS);
+	ctx->bitpos+=BITS;
+}
+template<int BITS,uint64_t VAL>
+void omx::uint_req(const iox_info* info)
+{
+	static_assert(VAL<=uint_field<BITS,uint64_t>::mask,"required value exceeds field width");
+	if(ctx->bitpos + BITS > ctx->bitlimit)
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, BITS);
+	ctx->bitpos+=BITS;
+}
+
+template<int BITS,class T>
+void icx::uint(T& var,const iox_info* info)
+{
+	(void)uint_field<BITS,T>::mask;
+	var=uint64(BITS,info);
+}
+template<int BITS,uint64_t VAL>
+void icx::uint_req(const iox_info* info)
+{
+	static_assert(VAL<=uint_field<BITS,uint64_t>::mask,"required value exceeds field width");
+	uint_req(BITS,VAL,info);
+}
+
+template<int BITS,class T>
+void ocx::uint(const T& var,const iox_info* info)
+{
+	(void)uint_field<BITS,T>::mask;
+	uint(BITS,(uint64_t)var,info);
+}
+template<int BITS,uint64_t VAL>
+void ocx::uint_req(const iox_info* info)
+{
+	static_assert(VAL<=uint_field<BITS,uint64_t>::mask,"required value exceeds field width");
+	uint(BITS,VAL,info);
+}
+
+template<int BITS,class T>
+void iox::uint(T& var,const iox_info* info)
+{
+	if(is_parsing())
+		if(is_binary())
+			as_ibx().uint<BITS>(var,info);
+		else
+			as_icx().uint<BITS>(var,info);
+	else
+		if(is_measuring())
+			as_omx().uint<BITS>(var,info);
+		else if(is_binary())
+			as_obx().uint<BITS>(var,info);
+		else
+			as_ocx().uint<BITS>(var,info);
+}
+template<int BITS,uint64_t VAL>
+void iox::uint_req(const iox_info* info)
+{
+	if(is_parsing())
+		if(is_binary())
+			as_ibx().uint_req<BITS,VAL>(info);
+		else
+			as_icx().uint_req<BITS,VAL>(info);
+	else
+		if(is_measuring())
+			as_omx().uint_req<BITS,VAL>(info);
+		else if(is_binary())
+			as_obx().uint_req<BITS,VAL>(info);
+		else
+			as_ocx().uint_req<BITS,VAL>(info);
+}
+
+/**
+ * \brief Fixed-size record of fields
+ * \details
+ * Record declares total size of its fields up-front, so bounds are checked once for all of them:
+ * \code
+ * template<class X> void io(X& x)
+ * {
+ *	record<X> r(x,24,DVB_INFO("service"));
+ *	r.template uint<16>(DVB_VAR(service_id));
+ *	r.template uint<8>(DVB_VAR(service_type));
+ * }
+ * \endcode
+ * For \ref ibx and \ref obx constructor checks that \b bitsize bits are available and fields
+ * are then read/written by ibCtx::nocheck_bits / obCtx::nocheck_bits.
+ * For other facades record just forwards to them.\n
+ * Fields must not exceed declared \b bitsize, otherwise result is undefined.
+ * If check fails in ioCtx::nothrow mode, fields of record are set to 0 and nothing is read.
+ * Record may end with \ref iox::named_block_begin, its length field counts to \b bitsize.
+ */
+template<class X>
+class record
+{
+public:
+	record(X& x, int, const iox_info* =NULL):x(x){}
+	/** \brief see \ref iox::uint<BITS> */
+	template<int BITS,class T>
+	void uint(T& var, const iox_info* info=NULL){x.template uint<BITS>(var,info);}
+	/** \brief see \ref iox::uint_req<BITS,VAL> */
+	template<int BITS,uint64_t VAL>
+	void uint_req(const iox_info* info=NULL){x.template uint_req<BITS,VAL>(info);}
+	/** \brief see \ref iox::named_block_begin */
+	void named_block_begin(int bitsize, const iox_info* info=NULL){x.named_block_begin(bitsize,info);}
+private:
+	X& x;
+};
+
+/** \brief Fixed-size record for binary parsing, see \ref record */
+template<>
+class record<ibx>
+{
+public:
+	record(ibx& x, int bitsize, const iox_info* info=NULL):x(x),ok(true)
+	{
+		if(x.ctx->bitpos + bitsize > x.ctx->bitlimit)
+		{
+			x.ctx->fail(info,ERR_NO_SPACE,"left %d bits, needed %d",x.ctx->bitlimit-x.ctx->bitpos, bitsize);
+			ok=false;
+		}
+	}
+	template<int BITS,class T>
+	void uint(T& var, const iox_info* =NULL)
+	{
+		(void)uint_field<BITS,T>::mask;
+		var=ok?x.ctx->nocheck_bits<BITS>():0;
+	}
+	template<int BITS,uint64_t VAL>
+	void uint_req(const iox_info* info=NULL)
+	{
+		static_assert(VAL<=uint_field<BITS,uint64_t>::mask,"required value exceeds field width");
+		if(!ok) return;
+		uint64_t v=x.ctx->nocheck_bits<BITS>();
+		if(v!=VAL)
+			x.ctx->fail(info,ERR_VALUE,"%llu read %llu required",(unsigned long long)v,(unsigned long long)VAL);
+	}
+	void named_block_begin(int bitsize, const iox_info* info=NULL)
+	{
+		if(!ok) return;
+		x.block_begin(x.ctx->nocheck_bits(bitsize),info);
+	}
+private:
+	ibx& x;
+	/** false when declared size was not available, fields are then not read */
+	bool ok;
+};
+
+/** \brief Fixed-size record for binary construction, see \ref record */
+template<>
+class record<obx>
+{
+public:
+	record(obx& x, int bitsize, const iox_info* info=NULL):x(x)
+	{
+		if(x.ctx->bitpos + bitsize > x.ctx->bitlimit)
+			throw Exception(x.ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",x.ctx->bitlimit-x.ctx->bitpos, bitsize);
+	}
+	template<int BITS,class T>
+	void uint(const T& var, const iox_info* info=NULL)
+	{
+		if((uint64_t)var>uint_field<BITS,T>::mask)
+			throw Exception(x.ctx,info,ERR_VALUE,"value %llu exceeds %d bits",(unsigned long long)var,BITS);
+		x.ctx->nocheck_bits<BITS>(var);
+	}
+	template<int BITS,uint64_t VAL>
+	void uint_req(const iox_info* =NULL)
+	{
+		static_assert(VAL<=uint_field<BITS,uint64_t>::mask,"required value exceeds field width");
+		x.ctx->nocheck_bits<BITS>(VAL);
+	}
+	void named_block_begin(int bitsize, const iox_info* info=NULL){x.named_block_begin(bitsize,info);}
+private:
+	obx& x;
+};
+
+/** \brief Fixed-size record for validation, see \ref record */
+template<>
+class record<ivx> : public record<ibx>
+{
+public:
+	record(ivx& x, int bitsize, const iox_info* info=NULL):record<ibx>(x,bitsize,info){}
 };
 
+/**
+ * \brief Run io() without throwing
+ * \param x - I/O facade, \ref iox or one of specialized ones
+ * \param obj - syntactic structure
+ * \param err - receives error when io() fails, may be NULL
+ * \return true on success
+ *
+ * io() runs in ioCtx::nothrow mode. Parsing facades do not throw, but record first error
+ * in context and let io() return early: blocks and loops end at once and \ref record skips fields.
+ * Error is not formatted, so rejecting corrupted input costs neither unwinding nor printf.
+ * Exceptions thrown anyway, for example by construction facades or by io() itself, are caught.
+ * Text of error is rendered on request:
+ * \code
+ * io_error err;
+ * if(!try_io(x,nit,&err))
+ *	printf("%s\n",err.message().c_str());
+ * \endcode
+ * After failure blocks may be left open, so context must be reset before it is used again.
+ */
+template<class X,class T>
+bool try_io(X& x, T& obj, io_error* err=NULL)
+{
+	bool saved=x.ctx->nothrow;
+	bool saved_failed=x.ctx->failed;
+	x.ctx->nothrow=true;
+	x.ctx->failed=false;
+	bool ok;
+	try
+	{
+		obj.io(x);
+		ok=!x.ctx->failed;
+		if(!ok && err) *err=x.ctx->error;
+	}
+	catch(const Exception& e)
+	{
+		ok=false;
+		if(err) *err=x.ctx->failed?x.ctx->error:e.error;
+	}
+	x.ctx->nothrow=saved;
+	x.ctx->failed=saved_failed;
+	return ok;
+}
+
 /*!
  * \def DVB_INFO(str)
  * Convenience macro for constructing access information for variable.
@@ -8,10 +8,32 @@ class psi_extractor
 {
 public:
 	typedef void (*section_ready)(void* ctx, const uint8_t* section, size_t size);
+	/**
+	 * \brief Callback for sections with result of CRC check.
+	 * \details Sections that do not carry CRC_32 are reported with crc_ok=true.
+	 */
+	typedef void (*section_ready_crc)(void* ctx, const uint8_t* section, size_t size, bool crc_ok);
+	/**
+	 * \brief Checking of CRC_32 of sections
+	 * \details CRC is calculated while payload of TS packets arrives, not as a separate pass over section.
+	 */
+	enum crc_check
+	{
+		crc_none,	///< CRC is not checked
+		crc_report,	///< result of check is passed to \ref section_ready_crc callback
+		crc_drop	///< sections with bad CRC are not passed to callback
+	};
 	static psi_extractor* create(size_t max_table_size,int max_dbg=0);
 	virtual ~psi_extractor(){};
 	virtual void ts_packet(const uint8_t* bytes)=0;
+	/**
+	 * \brief Process \b n consecutive TS packets, same as \ref ts_packet for each of them
+	 * \param stride - distance between packets, larger than 188 for 192 and 204 byte framing
+	 */
+	virtual void ts_packets(const uint8_t* packets, size_t n, size_t stride=188)=0;
 	virtual void on_section_ready(void* ctx, section_ready callback)=0;
+	virtual void on_section_ready(void* ctx, section_ready_crc callback)=0;
+	virtual void set_crc_check(crc_check mode)=0;
 };
 
 #endif
@@ -8,6 +8,7 @@ class sec2ts
 {
 public:
 	typedef void (*ts_packet_produced)(void* ctx, const uint8_t* packet);
+	typedef void (*ts_packets_produced)(void* ctx, const uint8_t* packets, size_t n);
 	typedef uint32_t (*adaptation_field)(void* ctx, uint8_t* packet, uint32_t size);
 
 	static sec2ts* create();
@@ -17,6 +18,13 @@ public:
 	virtual void flush()=0;
 	virtual void on_adaptation_field(void* ctx, adaptation_field callback)=0;
 	virtual void on_ts_packet_produced(void* ctx, ts_packet_produced callback)=0;
+	/**
+	 * \brief Collect produced packets and pass them in batches
+	 *
+	 * Callback receives up to \b max_packets consecutive packets, remaining ones are passed by \ref flush.
+	 * Replaces callback set by \ref on_ts_packet_produced.
+	 */
+	virtual void on_ts_packets_produced(void* ctx, ts_packets_produced callback, size_t max_packets)=0;
 	virtual void set_dbg_level(uint8_t level)=0;
 protected:
 	sec2ts();
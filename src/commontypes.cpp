@@ -1,9 +1,14 @@
 /** \file */
 
 #include "inc/io.h"
+#include "inc/commontypes.h"
+#include "inc/crc.h"
 #include <vector>
 #include <string>
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 namespace mopa
 {
 
@@ -11,8 +16,13 @@ namespace mopa
 
 std::string parse_string(icCtx* ctx,const iox_info* info)
 {
+	if(ctx->failed)
+		return "";
 	if((ctx->bitpos&7)!=0)
-		throw Exception(ctx,info,"String '%s' not byte-aligned",info?info->name:"");
+	{
+		ctx->fail(info,ERR_ALIGNMENT,"String '%s' not byte-aligned",info?info->name:"");
+		return "";
+	}
 	ctx->expect(info?info->name:"");
 	ctx->expect(":");
 	ctx->expect("'");
@@ -20,11 +30,11 @@ std::string parse_string(icCtx* ctx,const iox_info* info)
 	do
 	{
 		uint32_t c;
-		c=*(ctx->parse_pos++);
+		c=ctx->next_char();
 		if(c=='\'')break;
 		if(c=='\\')
 		{
-			c=*(ctx->parse_pos++);
+			c=ctx->next_char();
 			if(c=='\'' || c=='\\' || c=='\r' || c=='\n')
 			{
 				s+=c;
@@ -34,19 +44,31 @@ std::string parse_string(icCtx* ctx,const iox_info* info)
 			if(c>='0' && c<='7')
 				val=val*8+(c-'0');
 			else
-				throw Exception(ctx,info,"Illegal char `\\%3.3o`",c);
-			c=*(ctx->parse_pos++);
+			{
+				ctx->fail(info,ERR_SYNTAX,"Illegal char `\\%3.3o`",c);
+				return "";
+			}
+			c=ctx->next_char();
 			if(c>='0' && c<='7')
 				val=val*8+(c-'0');
 			else
-				throw Exception(ctx,info,"Illegal char `\\%3.3o`",c);
-			c=*(ctx->parse_pos++);
+			{
+				ctx->fail(info,ERR_SYNTAX,"Illegal char `\\%3.3o`",c);
+				return "";
+			}
+			c=ctx->next_char();
 			if(c>='0' && c<='7')
 				val=val*8+(c-'0');
 			else
-				throw Exception(ctx,info,"Illegal char `\\%3.3o`",c);
+			{
+				ctx->fail(info,ERR_SYNTAX,"Illegal char `\\%3.3o`",c);
+				return "";
+			}
 			if(val>255)
-				throw Exception(ctx,info,"Value too big");
+			{
+				ctx->fail(info,ERR_VALUE,"Value too big");
+				return "";
+			}
 			s+=(uint8_t)val;
 			continue;
 		}
@@ -55,209 +77,594 @@ std::string parse_string(icCtx* ctx,const iox_info* info)
 			s+=c;
 			continue;
 		}
-		throw Exception(ctx,info,"Illegal char `\\%3.3o`",c);
+		ctx->fail(info,ERR_SYNTAX,"Illegal char `\\%3.3o`",c);
+		return "";
 	}
 	while(true);
 
 	return s;
 }
 
-void produce_string(ocCtx* ctx,const std::string& str,const iox_info* info)
+/**
+ * How byte is written in string literal: 0 - as is, 1 - after backslash, 2 - as backslash and 3 octal digits.
+ */
+struct escape_lut
+{
+	uint8_t kind[256];
+	constexpr escape_lut():kind()
+	{
+		for(int c=0;c<256;c++)
+			kind[c]=(c>=32 && c<127)?0:2;
+		kind[(uint8_t)'\'']=1;
+		kind[(uint8_t)'\\']=1;
+		kind[(uint8_t)'\r']=1;
+		kind[(uint8_t)'\n']=1;
+	}
+};
+static constexpr escape_lut escape;
+#ifdef __SSE2__
+static const __m128i below=_mm_set1_epi8(31);
+static const __m128i above=_mm_set1_epi8(127);
+static const __m128i quote=_mm_set1_epi8('\'');
+static const __m128i backslash=_mm_set1_epi8('\\');
+/**
+ * Returns bit mask of bytes among 16 in \b c that are not written as is.
+ */
+static inline uint32_t escape_mask(__m128i c)
+{
+	//bytes from 128 up are negative, so they fail first compare
+	__m128i ok=_mm_and_si128(_mm_cmpgt_epi8(c,below),_mm_cmplt_epi8(c,above));
+	__m128i esc=_mm_or_si128(_mm_cmpeq_epi8(c,quote),_mm_cmpeq_epi8(c,backslash));
+	return _mm_movemask_epi8(_mm_andnot_si128(esc,ok))^0xffff;
+}
+#endif
+/**
+ * Writes escaped byte \b c to \b p, returns position after it.
+ */
+static inline char* escape_char(char* p,uint8_t c)
+{
+	*p++='\\';
+	if(escape.kind[c]==1)
+		*p++=c;
+	else
+	{
+		*p++='0'+((c>>6)&0x7);
+		*p++='0'+((c>>3)&0x7);
+		*p++='0'+((c>>0)&0x7);
+	}
+	return p;
+}
+
+void produce_string(ocCtx* ctx,const char* str,uint32_t len,const iox_info* info)
 {
 	if((ctx->bitpos&7)!=0)
-		throw Exception(ctx,info,"String '%s' not byte-aligned",info?info->name:"");
-	uint32_t len=str.size();
-	std::string s;
-	for(int i=0;i<len;i++)
+		throw Exception(ctx,info,ERR_ALIGNMENT,"String '%s' not byte-aligned",info?info->name:"");
+	//line is reserved so that it fits even with every byte in octal
+	std::string& s=ctx->prod;
+	uint32_t depth=ctx->scope_stack.size();
+	size_t name_len=strlen(info->name);
+	size_t size=depth*2+name_len+2+len*4+2;
+	char* start=ctx->line_space(size);
+	bool direct=start==NULL;
+	if(direct)
 	{
-		uint8_t c=str[i];
-		if(c=='\'' || c=='\\' || c=='\r' || c=='\n')
-		{
-			s+="\\";s+=c;
-			continue;
-		}
-		if(c>=32 && c<127)
+		size_t pos=s.size();
+		s.resize(pos+size);
+		start=&s[pos];
+	}
+	char* p=start;
+	memset(p,' ',depth*2);
+	p+=depth*2;
+	memcpy(p,info->name,name_len);
+	p+=name_len;
+	*p++=':';
+	*p++='\'';
+	const char* end=str+len;
+#ifdef __SSE2__
+	//16 bytes are stored at once, output advances up to first byte that is escaped
+	while(end-str>=16)
+	{
+		__m128i c=_mm_loadu_si128((const __m128i*)str);
+		_mm_storeu_si128((__m128i*)p,c);
+		uint32_t mask=escape_mask(c);
+		if(mask==0)
 		{
-			s+=c;
+			p+=16;
+			str+=16;
 			continue;
 		}
-		//s+='.';continue;
-		s+='\\';
-		s+=('0'+((c>>6)&0x7));
-		s+=('0'+((c>>3)&0x7));
-		s+=('0'+((c>>0)&0x7));
+		uint32_t run=__builtin_ctz(mask);
+		p=escape_char(p+run,str[run]);
+		str+=run+1;
 	}
-	ctx->prod+=std::string(ctx->scope_stack.size()*2,' ');
-	ctx->prod+=info->name;
-	ctx->prod+=":'";
-	ctx->prod+=s+"'\n";
-	//ctx->bitpos+=(len+1)*8;
+#endif
+	while(str<end)
+	{
+		uint8_t c=*str++;
+		if(escape.kind[c]==0)
+			*p++=c;
+		else
+			p=escape_char(p,c);
+	}
+	*p++='\'';
+	*p++='\n';
+	if(direct)
+		s.resize(p-s.data());
+	else
+		ctx->lines_len+=p-start;
+	ctx->chunk_done();
 }
 
-void short_string_io(iox& x,std::string& str,const iox_info* info=NULL)
+/**
+ * \brief What string_io needs from string type
+ * \details \b from_parsed stores characters located in parsed data,
+ * \b from_text stores characters decoded from text.
+ */
+template<class S>
+struct string_traits;
+template<>
+struct string_traits<std::string>
+{
+	static const char* data(const std::string& s){return s.data();}
+	static uint32_t size(const std::string& s){return s.size();}
+	static void from_parsed(std::string& s,const char* str,uint32_t len){s.assign(str,len);}
+	static void from_text(std::string& s,std::string& text){s.swap(text);}
+	static void clear(std::string& s){s.clear();}
+};
+template<>
+struct string_traits<string_ref>
+{
+	static const char* data(const string_ref& s){return s.data();}
+	static uint32_t size(const string_ref& s){return s.size();}
+	static void from_parsed(string_ref& s,const char* str,uint32_t len){s.refer(str,len);}
+	static void from_text(string_ref& s,std::string& text){s=text;}
+	static void clear(string_ref& s){s=std::string();}
+};
+
+/**
+ * Calls \b f with facade for current mode of \b x.
+ */
+template<class F>
+static void facade_dispatch(iox& x,F f)
 {
 	if(x.is_parsing())
-		if(x.is_binary())
+		if(x.is_validating())
+		{
+			ivx y=x.as_ivx();
+			f(y);
+		}
+		else if(x.is_binary())
 		{
 			ibx y=x.as_ibx();
-			if((y.ctx->bitpos&7)!=0)
-				throw Exception(y.ctx,info,"String '%s' not byte-aligned",info?info->name:"");
-			uint8_t len;
-			len=y.uint8(8,info);
-			if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
-				throw Exception(y.ctx,info,"String '%s' is %d length, only %d bits available",
-						info?info->name:"",len, y.ctx->bitlimit-y.ctx->bitpos);
-			str=std::string((char*)&y.ctx->data[y.ctx->bitpos/8],len);
-			y.ctx->bitpos+=len*8;
+			f(y);
 		}
 		else
 		{
 			icx y=x.as_icx();
-			str=parse_string(y.ctx,info);
-			uint8_t len=1+str.size();
-			if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
-				throw Exception(y.ctx,info,"String '%s' requires %d bytes length, only %d bytes available",
-						info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
-			y.ctx->bitpos+=len*8;
+			f(y);
 		}
 	else
-		if(x.is_binary())
+		if(x.is_measuring())
+		{
+			omx y=x.as_omx();
+			f(y);
+		}
+		else if(x.is_binary())
 		{
 			obx y=x.as_obx();
-			if((y.ctx->bitpos&7)!=0)
-				throw Exception(y.ctx,info,"String '%s' not byte-aligned",info?info->name:"");
-			uint32_t len=str.size();
-			if(len>255)
-				throw Exception(y.ctx,info,"String '%s' length %d exceeds max 255 chars",info?info->name:"");
-			if(y.ctx->bitpos+(len+1)*8>y.ctx->bitlimit)
-							throw Exception(y.ctx,info,"String '%s' requires %d bytes length, only %d bytes available",
-									info?info->name:"",len+1, (y.ctx->bitlimit-y.ctx->bitpos)/8);
-			y.uint(8,(uint8_t)len,info);
-			memcpy(y.ctx->data+y.ctx->bitpos/8,str.c_str(),len);
-			y.ctx->bitpos+=len*8;
+			f(y);
 		}
 		else
 		{
 			ocx y=x.as_ocx();
-			uint32_t len=str.size();
-			if(len>255)
-				throw Exception(y.ctx,info,"String '%s' length %d exceeds max 255 chars",info?info->name:"");
-			if(y.ctx->bitpos+(len+1)*8>y.ctx->bitlimit)
-				throw Exception(y.ctx,info,"String '%s' requires %d bytes length, only %d bytes available",
-						info?info->name:"",len+1, (y.ctx->bitlimit-y.ctx->bitpos)/8);
-			produce_string(y.ctx,str,info);
-			y.ctx->bitpos+=(len+1)*8;
+			f(y);
 		}
 }
-//template<uint32_t num_chars>
-//void fixed_string_io(dvb::iox& x,std::string& str,const iox_info* info=NULL)
-void fixed_string_io(iox& x,uint32_t num_chars,std::string& str,const iox_info* info=NULL)
 
+/**
+ * Reads length byte and locates string in parsed data.
+ */
+static const char* short_string_in(ibx& y,uint8_t& len,const iox_info* info)
+{
+	len=0;
+	if((y.ctx->bitpos&7)!=0)
+	{
+		y.ctx->fail(info,ERR_ALIGNMENT,"String '%s' not byte-aligned",info?info->name:"");
+		return "";
+	}
+	len=y.uint8(8,info);
+	if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
+	{
+		y.ctx->fail(info,ERR_NO_SPACE,"String '%s' is %d length, only %d bits available",
+				info?info->name:"",len, y.ctx->bitlimit-y.ctx->bitpos);
+		len=0;
+		return "";
+	}
+	const char* str=(const char*)&y.ctx->data[y.ctx->bitpos/8];
+	y.ctx->bitpos+=len*8;
+	return str;
+}
+static void short_string_out(obx& y,const char* str,uint32_t len,const iox_info* info)
+{
+	if((y.ctx->bitpos&7)!=0)
+		throw Exception(y.ctx,info,ERR_ALIGNMENT,"String '%s' not byte-aligned",info?info->name:"");
+	if(len>255)
+		throw Exception(y.ctx,info,ERR_VALUE,"String '%s' length %d exceeds max 255 chars",info?info->name:"",len);
+	if(y.ctx->bitpos+(len+1)*8>y.ctx->bitlimit)
+					throw Exception(y.ctx,info,ERR_NO_SPACE,"String '%s' requires %d bytes length, only %d bytes available",
+							info?info->name:"",len+1, (y.ctx->bitlimit-y.ctx->bitpos)/8);
+	y.uint(8,(uint8_t)len,info);
+	memcpy(y.ctx->data+y.ctx->bitpos/8,str,len);
+	y.ctx->bitpos+=len*8;
+	y.ctx->advance();
+}
+static void short_string_out(omx& y,const char*,uint32_t len,const iox_info* info)
+{
+	if((y.ctx->bitpos&7)!=0)
+		throw Exception(y.ctx,info,ERR_ALIGNMENT,"String '%s' not byte-aligned",info?info->name:"");
+	if(len>255)
+		throw Exception(y.ctx,info,ERR_VALUE,"String '%s' length %d exceeds max 255 chars",info?info->name:"",len);
+	if(y.ctx->bitpos+(len+1)*8>y.ctx->bitlimit)
+		throw Exception(y.ctx,info,ERR_NO_SPACE,"String '%s' requires %d bytes length, only %d bytes available",
+				info?info->name:"",len+1, (y.ctx->bitlimit-y.ctx->bitpos)/8);
+	y.ctx->bitpos+=(len+1)*8;
+}
+static void short_string_out(ocx& y,const char* str,uint32_t len,const iox_info* info)
+{
+	if(len>255)
+		throw Exception(y.ctx,info,ERR_VALUE,"String '%s' length %d exceeds max 255 chars",info?info->name:"",len);
+	if(y.ctx->bitpos+(len+1)*8>y.ctx->bitlimit)
+		throw Exception(y.ctx,info,ERR_NO_SPACE,"String '%s' requires %d bytes length, only %d bytes available",
+				info?info->name:"",len+1, (y.ctx->bitlimit-y.ctx->bitpos)/8);
+	produce_string(y.ctx,str,len,info);
+	y.ctx->bitpos+=(len+1)*8;
+}
+
+template<class S>
+static void short_string(ibx& y,S& str,const iox_info* info)
+{
+	uint8_t len;
+	const char* s=short_string_in(y,len,info);
+	string_traits<S>::from_parsed(str,s,len);
+}
+template<class S>
+static void short_string(icx& y,S& str,const iox_info* info)
+{
+	std::string s=parse_string(y.ctx,info);
+	uint8_t len=1+s.size();
+	if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
+	{
+		y.ctx->fail(info,ERR_NO_SPACE,"String '%s' requires %d bytes length, only %d bytes available",
+				info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
+		return;
+	}
+	y.ctx->bitpos+=len*8;
+	string_traits<S>::from_text(str,s);
+}
+template<class S>
+static void short_string(obx& y,S& str,const iox_info* info)
+{
+	short_string_out(y,string_traits<S>::data(str),string_traits<S>::size(str),info);
+}
+template<class S>
+static void short_string(ocx& y,S& str,const iox_info* info)
+{
+	short_string_out(y,string_traits<S>::data(str),string_traits<S>::size(str),info);
+}
+template<class S>
+static void short_string(omx& y,S& str,const iox_info* info)
+{
+	short_string_out(y,string_traits<S>::data(str),string_traits<S>::size(str),info);
+}
+template<class S>
+static void short_string(ipx& y,S& str,const iox_info* info)
+{
+	if(y.is_skipping())
+		string_traits<S>::clear(str);
+	else
+	{
+		ibx z(y.ctx);
+		short_string(z,str,info);
+	}
+}
+template<class S>
+static void short_string(ivx& y,S&,const iox_info* info)
+{
+	uint8_t len;
+	short_string_in(y,len,info);
+}
+template<class S>
+static void short_string(iox& x,S& str,const iox_info* info)
+{
+	facade_dispatch(x,[&str,info](auto& y){short_string(y,str,info);});
+}
+
+/**
+ * Locates string of fixed length in parsed data.
+ */
+static const char* fixed_string_in(ibx& y,uint32_t num_chars,const iox_info* info)
+{
+	if((y.ctx->bitpos&7)!=0)
+	{
+		y.ctx->fail(info,ERR_ALIGNMENT,"String '%s' not byte-aligned",info?info->name:"");
+		return NULL;
+	}
+	uint8_t len=num_chars;
+	if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
+	{
+		y.ctx->fail(info,ERR_NO_SPACE,"String '%s' is %d length, only %d bytes available",
+				info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
+		return NULL;
+	}
+	const char* str=(const char*)&y.ctx->data[y.ctx->bitpos/8];
+	y.ctx->bitpos+=len*8;
+	return str;
+}
+static void fixed_string_out(obx& y,uint32_t num_chars,const char* str,uint32_t len,const iox_info* info)
+{
+	if((y.ctx->bitpos&7)!=0)
+		throw Exception(y.ctx,info,ERR_ALIGNMENT,"String '%s' not byte-aligned",info?info->name:"");
+	if(len!=num_chars)
+					throw Exception(y.ctx,info,ERR_VALUE,"String '%s' must be %d long",info?info->name:"",num_chars);
+	if(y.ctx->bitpos+(len)*8>y.ctx->bitlimit)
+		throw Exception(y.ctx,info,ERR_NO_SPACE,"String '%s' requires %d bytes length, only %d bytes available",
+				info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
+	memcpy(y.ctx->data+y.ctx->bitpos/8,str,len);
+	y.ctx->bitpos+=len*8;
+	y.ctx->advance();
+}
+static void fixed_string_out(omx& y,uint32_t num_chars,const char*,uint32_t len,const iox_info* info)
+{
+	if((y.ctx->bitpos&7)!=0)
+		throw Exception(y.ctx,info,ERR_ALIGNMENT,"String '%s' not byte-aligned",info?info->name:"");
+	if(len!=num_chars)
+		throw Exception(y.ctx,info,ERR_VALUE,"String '%s' must be %d long",info?info->name:"",num_chars);
+	if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
+		throw Exception(y.ctx,info,ERR_NO_SPACE,"String '%s' requires %d bytes length, only %d bytes available",
+				info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
+	y.ctx->bitpos+=len*8;
+}
+static void fixed_string_out(ocx& y,uint32_t num_chars,const char* str,uint32_t len,const iox_info* info)
+{
+	if(len!=num_chars)
+		throw Exception(y.ctx,info,ERR_VALUE,"String '%s' must be %d long",info?info->name:"",num_chars);
+	if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
+		throw Exception(y.ctx,info,ERR_NO_SPACE,"String '%s' requires %d bytes length, only %d bytes available",
+				info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
+	produce_string(y.ctx,str,len,info);
+	y.ctx->bitpos+=len*8;
+}
+
+template<class S>
+static void fixed_string(ibx& y,uint32_t num_chars,S& str,const iox_info* info)
+{
+	const char* s=fixed_string_in(y,num_chars,info);
+	if(s==NULL)
+		string_traits<S>::clear(str);
+	else
+		string_traits<S>::from_parsed(str,s,(uint8_t)num_chars);
+}
+template<class S>
+static void fixed_string(icx& y,uint32_t,S& str,const iox_info* info)
+{
+	std::string s=parse_string(y.ctx,info);
+	uint8_t len=s.size();
+	if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
+	{
+		y.ctx->fail(info,ERR_NO_SPACE,"String '%s' requires %d bytes length, only %d bytes available",
+				info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
+		return;
+	}
+	y.ctx->bitpos+=len*8;
+	string_traits<S>::from_text(str,s);
+}
+template<class S>
+static void fixed_string(obx& y,uint32_t num_chars,S& str,const iox_info* info)
+{
+	fixed_string_out(y,num_chars,string_traits<S>::data(str),string_traits<S>::size(str),info);
+}
+template<class S>
+static void fixed_string(ocx& y,uint32_t num_chars,S& str,const iox_info* info)
+{
+	fixed_string_out(y,num_chars,string_traits<S>::data(str),string_traits<S>::size(str),info);
+}
+template<class S>
+static void fixed_string(omx& y,uint32_t num_chars,S& str,const iox_info* info)
+{
+	fixed_string_out(y,num_chars,string_traits<S>::data(str),string_traits<S>::size(str),info);
+}
+template<class S>
+static void fixed_string(ipx& y,uint32_t num_chars,S& str,const iox_info* info)
+{
+	if(y.is_skipping())
+		string_traits<S>::clear(str);
+	else
+	{
+		ibx z(y.ctx);
+		fixed_string(z,num_chars,str,info);
+	}
+}
+template<class S>
+static void fixed_string(ivx& y,uint32_t num_chars,S&,const iox_info* info)
+{
+	fixed_string_in(y,num_chars,info);
+}
+template<class S>
+static void fixed_string(iox& x,uint32_t num_chars,S& str,const iox_info* info)
+{
+	facade_dispatch(x,[num_chars,&str,info](auto& y){fixed_string(y,num_chars,str,info);});
+}
+
+template<class X,class S>
+void short_string_io(X& x,S& str,const iox_info* info)
+{
+	short_string(x,str,info);
+}
+template<class X,class S>
+void fixed_string_io(X& x,uint32_t num_chars,S& str,const iox_info* info)
+{
+	fixed_string(x,num_chars,str,info);
+}
+#define MOPA_STRING_IO(X) \
+	template void short_string_io<X,std::string>(X&,std::string&,const iox_info*); \
+	template void short_string_io<X,string_ref>(X&,string_ref&,const iox_info*); \
+	template void fixed_string_io<X,std::string>(X&,uint32_t,std::string&,const iox_info*); \
+	template void fixed_string_io<X,string_ref>(X&,uint32_t,string_ref&,const iox_info*);
+MOPA_STRING_IO(iox)
+MOPA_STRING_IO(ibx)
+MOPA_STRING_IO(obx)
+MOPA_STRING_IO(icx)
+MOPA_STRING_IO(ocx)
+MOPA_STRING_IO(ipx)
+MOPA_STRING_IO(ivx)
+MOPA_STRING_IO(omx)
+#undef MOPA_STRING_IO
+
+/**
+ * \return false if error was recorded in ioCtx::nothrow mode
+ */
+static bool crc_check_alignment(ioCtx* ctx,uint32_t started_at,const iox_info* info)
+{
+	if((started_at&7) != 0)
+	{
+		ctx->fail(info,ERR_ALIGNMENT,"CRC block was not started at byte aligned");
+		return false;
+	}
+	if((ctx->bitpos&7) != 0)
+	{
+		ctx->fail(info,ERR_ALIGNMENT,"CRC not byte aligned");
+		return false;
+	}
+	return true;
+}
+
+void crc_io(ibx& y,uint32_t started_at,uint32_t& crc,const iox_info* info)
+{
+	if(y.ctx->failed || !crc_check_alignment(y.ctx,started_at,info))
+	{
+		crc=0;
+		return;
+	}
+	uint32_t bytes=(y.ctx->bitpos-started_at)/8;
+	uint32_t crc_calculated;
+	crc_calculated=dvb_crc32(y.ctx->data+started_at/8,bytes);
+	y.uint(32,crc,info);
+	if(crc_calculated!=crc)
+		y.ctx->fail(info,ERR_CRC,"CRC mismatch. read=%8.8x,calculated=%8.8x",crc,crc_calculated);
+}
+void crc_io(obx& y,uint32_t started_at,uint32_t& crc,const iox_info* info)
+{
+	if(!crc_check_alignment(y.ctx,started_at,info))
+		return;
+	uint32_t bytes=(y.ctx->bitpos-started_at)/8;
+	crc=dvb_crc32(y.ctx->data+started_at/8,bytes);
+	y.uint(32,crc,info);
+}
+void crc_io(icx& y,uint32_t started_at,uint32_t& crc,const iox_info* info)
+{
+	if(!crc_check_alignment(y.ctx,started_at,info))
+		return;
+	y.uint(32,crc,info);
+}
+void crc_io(ocx& y,uint32_t started_at,uint32_t& crc,const iox_info* info)
+{
+	if(!crc_check_alignment(y.ctx,started_at,info))
+		return;
+	y.uint(32,crc,info);
+}
+void crc_io(omx& y,uint32_t started_at,uint32_t& crc,const iox_info* info)
+{
+	if(!crc_check_alignment(y.ctx,started_at,info))
+		return;
+	y.uint(32,crc,info);
+}
+void crc_io(ipx& y,uint32_t started_at,uint32_t& crc,const iox_info* info)
+{
+	if(y.is_skipping())
+	{
+		crc=0;
+		return;
+	}
+	if(!crc_check_alignment(y.ctx,started_at,info))
+		return;
+	y.uint(32,crc,info);
+}
+void crc_io(iox& x,uint32_t started_at,uint32_t& crc,const iox_info* info)
 {
 	if(x.is_parsing())
 		if(x.is_binary())
 		{
 			ibx y=x.as_ibx();
-			if((y.ctx->bitpos&7)!=0)
-				throw Exception(y.ctx,info,"String '%s' not byte-aligned",info?info->name:"");
-			uint8_t len=num_chars;
-			if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
-				throw Exception(y.ctx,info,"String '%s' is %d length, only %d bytes available",
-						info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
-			str=std::string((char*)&y.ctx->data[y.ctx->bitpos/8],len);
-			y.ctx->bitpos+=len*8;
+			crc_io(y,started_at,crc,info);
 		}
 		else
 		{
 			icx y=x.as_icx();
-			str=parse_string(y.ctx,info);
-			uint8_t len=str.size();
-			if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
-				throw Exception(y.ctx,info,"String '%s' requires %d bytes length, only %d bytes available",
-						info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
-			y.ctx->bitpos+=len*8;
-
+			crc_io(y,started_at,crc,info);
 		}
 	else
-		if(x.is_binary())
+		if(x.is_measuring())
+		{
+			omx y=x.as_omx();
+			crc_io(y,started_at,crc,info);
+		}
+		else if(x.is_binary())
 		{
 			obx y=x.as_obx();
-			if((y.ctx->bitpos&7)!=0)
-				throw Exception(y.ctx,info,"String '%s' not byte-aligned",info?info->name:"");
-			uint32_t len=str.size();
-			if(str.size()!=num_chars)
-							throw Exception(y.ctx,info,"String '%s' must be %d long",info?info->name:"",num_chars);
-			if(y.ctx->bitpos+(len)*8>y.ctx->bitlimit)
-				throw Exception(y.ctx,info,"String '%s' requires %d bytes length, only %d bytes available",
-						info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
-			memcpy(y.ctx->data+y.ctx->bitpos/8,str.c_str(),len);
-			y.ctx->bitpos+=len*8;
+			crc_io(y,started_at,crc,info);
 		}
 		else
 		{
 			ocx y=x.as_ocx();
-			uint32_t len=str.size();
-			if(len!=num_chars)
-				throw Exception(y.ctx,info,"String '%s' must be %d long",info?info->name:"",num_chars);
-			if(y.ctx->bitpos+len*8>y.ctx->bitlimit)
-				throw Exception(y.ctx,info,"String '%s' requires %d bytes length, only %d bytes available",
-						info?info->name:"",len, (y.ctx->bitlimit-y.ctx->bitpos)/8);
-			produce_string(y.ctx,str,info);
-			y.ctx->bitpos+=str.size()*8;
+			crc_io(y,started_at,crc,info);
 		}
 }
 
-uint32_t dvb_crc32(const uint8_t *data, int len);
-
-void crc_io(iox& x,uint32_t started_at,uint32_t& crc,const iox_info* info)
+void crc_late_fix(obx& y,uint32_t started_at,uint32_t crc_pos,uint32_t& crc,const iox_info* info)
+{
+	if(!crc_check_alignment(y.ctx,started_at,info))
+		return;
+	uint32_t bytes=(crc_pos-started_at)/8;
+	crc=dvb_crc32(y.ctx->data+started_at/8,bytes);
+	y.ctx->advance();
+	uint32_t saved_pos=y.ctx->bitpos;
+	y.ctx->bitpos=crc_pos;
+	y.uint(32,crc,info);
+	y.ctx->bitpos=saved_pos;
+}
+void crc_late_fix(ibx& y,uint32_t started_at,uint32_t,uint32_t&,const iox_info* info)
+{
+	crc_check_alignment(y.ctx,started_at,info);
+}
+void crc_late_fix(icx& y,uint32_t started_at,uint32_t,uint32_t&,const iox_info* info)
+{
+	crc_check_alignment(y.ctx,started_at,info);
+}
+void crc_late_fix(ocx& y,uint32_t started_at,uint32_t,uint32_t&,const iox_info* info)
+{
+	crc_check_alignment(y.ctx,started_at,info);
+}
+void crc_late_fix(omx& y,uint32_t started_at,uint32_t,uint32_t&,const iox_info* info)
+{
+	crc_check_alignment(y.ctx,started_at,info);
+}
+void crc_late_fix(ipx&,uint32_t,uint32_t,uint32_t&,const iox_info*)
 {
-	if((started_at&7) != 0)
-		throw Exception(x.ctx,info,"CRC block was not started at byte aligned");
-	if((x.ctx->bitpos&7) != 0)
-		throw Exception(x.ctx,info,"CRC not byte aligned");
-	if(x.is_binary())
-	{
-		if(x.is_parsing())
-		{
-			ibx y=x.as_ibx();
-			uint32_t bytes=(y.ctx->bitpos-started_at)/8;
-			uint32_t crc_calculated;
-			crc_calculated=dvb_crc32(y.ctx->data+started_at/8,bytes);
-			x.uint(32,crc,info);
-			if(crc_calculated!=crc)
-				throw Exception(x.ctx,info,"CRC mismatch. read=%8.8x,calculated=%8.8x",crc,crc_calculated);
-		}
-		else
-		{
-			obx y=x.as_obx();
-			uint32_t bytes=(y.ctx->bitpos-started_at)/8;
-			crc=dvb_crc32(y.ctx->data+started_at/8,bytes);
-			x.uint(32,crc,info);
-		}
-	}
-	else
-		x.uint(32,crc,info);
 }
-
 void crc_late_fix(iox& x,uint32_t started_at,uint32_t crc_pos,uint32_t& crc,const iox_info* info)
 {
-	if((started_at&7) != 0)
-		throw Exception(x.ctx,info,"CRC block was not started at byte aligned");
-	if((x.ctx->bitpos&7) != 0)
-		throw Exception(x.ctx,info,"CRC not byte aligned");
-	if(x.is_binary())
+	if(x.is_measuring())
 	{
-		if(!x.is_parsing())
-		{
-			obx y=x.as_obx();
-			uint32_t bytes=(crc_pos-started_at)/8;
-			crc=dvb_crc32(y.ctx->data+started_at/8,bytes);
-			uint32_t saved_pos=x.ctx->bitpos;
-			x.ctx->bitpos=crc_pos;
-			x.as_obx().uint(32,crc,info);
-			x.ctx->bitpos=saved_pos;
-		}
+		omx y=x.as_omx();
+		crc_late_fix(y,started_at,crc_pos,crc,info);
 	}
+	else if(x.is_binary() && !x.is_parsing())
+	{
+		obx y=x.as_obx();
+		crc_late_fix(y,started_at,crc_pos,crc,info);
+	}
+	else
+		crc_check_alignment(x.ctx,started_at,info);
 }
 
 }
@@ -1,11 +1,16 @@
 #include <inttypes.h>
+#include "inc/crc.h"
+#if MOPA_CRC_CLMUL
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 namespace mopa
 {
 
 
 
 
-static const uint32_t crc_table[256] = {
+static constexpr uint32_t crc_table[256] = {
 	0x00000000, 0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b,
 	0x1a864db2, 0x1e475005, 0x2608edb8, 0x22c9f00f, 0x2f8ad6d6, 0x2b4bcb61,
 	0x350c9b64, 0x31cd86d3, 0x3c8ea00a, 0x384fbdbd, 0x4c11db70, 0x48d0c6c7,
@@ -51,10 +56,43 @@ static const uint32_t crc_table[256] = {
 	0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
 };
 
-uint32_t dvb_crc32(const uint8_t *data, int len)
+/**
+ * Tables for slicing, slice[k][b] is CRC of byte b followed by k zero bytes.
+ */
+struct crc_slice_tables
+{
+	uint32_t slice[16][256];
+	constexpr crc_slice_tables():slice()
+	{
+		for(int i=0;i<256;i++)
+			slice[0][i]=crc_table[i];
+		for(int k=1;k<16;k++)
+			for(int i=0;i<256;i++)
+				slice[k][i]=(slice[k-1][i]<<8)^crc_table[slice[k-1][i]>>24];
+	}
+};
+static constexpr crc_slice_tables crc_slices;
+
+static inline uint32_t load_be32(const uint8_t* p)
+{
+	return ((uint32_t)p[0]<<24)|((uint32_t)p[1]<<16)|((uint32_t)p[2]<<8)|p[3];
+}
+
+static inline uint32_t crc_slice4(const uint32_t (*t)[256], uint32_t w)
+{
+	return t[3][w>>24]^t[2][(w>>16)&0xff]^t[1][(w>>8)&0xff]^t[0][w&0xff];
+}
+
+static inline uint32_t crc_update16(uint32_t crc, const uint8_t* p)
+{
+	const uint32_t (*t)[256]=crc_slices.slice;
+	return crc_slice4(t+12,crc^load_be32(p))^crc_slice4(t+8,load_be32(p+4))^
+			crc_slice4(t+4,load_be32(p+8))^crc_slice4(t,load_be32(p+12));
+}
+
+static uint32_t crc32_bytewise(uint32_t crc, const uint8_t *data, int len)
 {
     int i;
-    uint32_t crc = 0xffffffff;
 
     for (i=0; i<len; i++)
         crc = (crc << 8) ^ crc_table[((crc >> 24) ^ *data++) & 0xff];
@@ -62,4 +100,205 @@ uint32_t dvb_crc32(const uint8_t *data, int len)
     return crc;
 }
 
+static uint32_t crc32_slice8(uint32_t crc, const uint8_t *data, int len)
+{
+	const uint32_t (*t)[256]=crc_slices.slice;
+	for(;len>=8;len-=8,data+=8)
+		crc=crc_slice4(t+4,crc^load_be32(data))^crc_slice4(t,load_be32(data+4));
+	for(;len>0;len--)
+		crc=(crc<<8)^crc_table[(crc>>24)^*data++];
+	return crc;
+}
+
+static uint32_t crc32_slice16(uint32_t crc, const uint8_t *data, int len)
+{
+	for(;len>=16;len-=16,data+=16)
+		crc=crc_update16(crc,data);
+	for(;len>0;len--)
+		crc=(crc<<8)^crc_table[(crc>>24)^*data++];
+	return crc;
+}
+
+#if MOPA_CRC_CLMUL
+/**
+ * x^n mod P, for folding constants.
+ */
+static constexpr uint64_t crc_xpow_mod(int n)
+{
+	uint32_t r=1;
+	for(int i=0;i<n;i++)
+		r=(r<<1)^((r&0x80000000)?0x04c11db7:0);
+	return r;
+}
+static constexpr uint64_t crc_k512[2]={crc_xpow_mod(512),crc_xpow_mod(512+64)};
+static constexpr uint64_t crc_k128[2]={crc_xpow_mod(128),crc_xpow_mod(128+64)};
+
+/**
+ * Folds 128 bits of \b a over distance in \b k, low half x^T mod P, high half x^(T+64) mod P.
+ */
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i crc_fold(__m128i a, __m128i k, __m128i b)
+{
+	return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(a,k,0x11),_mm_clmulepi64_si128(a,k,0x00)),b);
+}
+
+bool dvb_crc32_clmul_supported()
+{
+	unsigned int eax,ebx,ecx,edx;
+	if(!__get_cpuid(1,&eax,&ebx,&ecx,&edx))
+		return false;
+	return (ecx&bit_PCLMUL) && (ecx&bit_SSSE3);
+}
+
+/*
+ * Message is loaded with bytes reversed, so bit i of register is coefficient of x^i,
+ * and first bit of message is the highest one. Folding replaces A*x^T by congruent
+ * A_hi*(x^(T+64) mod P) + A_lo*(x^T mod P), which fits in 128 bits.
+ * Remaining 128 bits R are reduced to R*x^32 mod P by a single slicing step.
+ */
+__attribute__((target("pclmul,ssse3")))
+static uint32_t crc32_clmul(uint32_t crc, const uint8_t *data, int len)
+{
+	if(len<64)
+		return crc32_slice16(crc,data,len);
+	const __m128i bswap=_mm_set_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+	const __m128i k512=_mm_set_epi64x(crc_k512[1],crc_k512[0]);
+	const __m128i k128=_mm_set_epi64x(crc_k128[1],crc_k128[0]);
+	const __m128i* p=(const __m128i*)data;
+	__m128i a0=_mm_shuffle_epi8(_mm_loadu_si128(p+0),bswap);
+	__m128i a1=_mm_shuffle_epi8(_mm_loadu_si128(p+1),bswap);
+	__m128i a2=_mm_shuffle_epi8(_mm_loadu_si128(p+2),bswap);
+	__m128i a3=_mm_shuffle_epi8(_mm_loadu_si128(p+3),bswap);
+	//initial value is added to first 32 bits
+	a0=_mm_xor_si128(a0,_mm_set_epi32(crc,0,0,0));
+	p+=4;
+	len-=64;
+	for(;len>=64;len-=64,p+=4)
+	{
+		a0=crc_fold(a0,k512,_mm_shuffle_epi8(_mm_loadu_si128(p+0),bswap));
+		a1=crc_fold(a1,k512,_mm_shuffle_epi8(_mm_loadu_si128(p+1),bswap));
+		a2=crc_fold(a2,k512,_mm_shuffle_epi8(_mm_loadu_si128(p+2),bswap));
+		a3=crc_fold(a3,k512,_mm_shuffle_epi8(_mm_loadu_si128(p+3),bswap));
+	}
+	a0=crc_fold(a0,k128,a1);
+	a0=crc_fold(a0,k128,a2);
+	a0=crc_fold(a0,k128,a3);
+	for(;len>=16;len-=16,p++)
+		a0=crc_fold(a0,k128,_mm_shuffle_epi8(_mm_loadu_si128(p),bswap));
+	uint8_t r[16];
+	_mm_storeu_si128((__m128i*)r,_mm_shuffle_epi8(a0,bswap));
+	crc=crc_update16(0,r);
+	data=(const uint8_t*)p;
+	for(;len>0;len--)
+		crc=(crc<<8)^crc_table[(crc>>24)^*data++];
+	return crc;
+}
+
+uint32_t dvb_crc32_clmul(const uint8_t *data, int len)
+{
+	return crc32_clmul(0xffffffff,data,len);
+}
+#endif
+
+uint32_t dvb_crc32_bytewise(const uint8_t *data, int len)
+{
+	return crc32_bytewise(0xffffffff,data,len);
+}
+
+uint32_t dvb_crc32_slice8(const uint8_t *data, int len)
+{
+	return crc32_slice8(0xffffffff,data,len);
+}
+
+uint32_t dvb_crc32_slice16(const uint8_t *data, int len)
+{
+	return crc32_slice16(0xffffffff,data,len);
+}
+
+typedef uint32_t (*crc32_function)(uint32_t crc, const uint8_t *data, int len);
+
+static crc32_function crc32_select()
+{
+#if MOPA_CRC_CLMUL
+	if(dvb_crc32_clmul_supported())
+		return crc32_clmul;
+#endif
+#if MOPA_CRC_SLICES==16
+	return crc32_slice16;
+#elif MOPA_CRC_SLICES==8
+	return crc32_slice8;
+#elif MOPA_CRC_SLICES==1
+	return crc32_bytewise;
+#else
+#error MOPA_CRC_SLICES must be 1, 8 or 16
+#endif
+}
+
+uint32_t dvb_crc32_update(uint32_t crc, const uint8_t *data, int len)
+{
+	static const crc32_function impl=crc32_select();
+	return impl(crc,data,len);
+}
+
+uint32_t dvb_crc32(const uint8_t *data, int len)
+{
+	return dvb_crc32_update(0xffffffff,data,len);
+}
+
+
+/**
+ * a*b mod P
+ */
+static constexpr uint32_t crc_mulmod(uint32_t a, uint32_t b)
+{
+	uint32_t r=0;
+	for(int i=31;i>=0;i--)
+	{
+		r=(r<<1)^((r&0x80000000)?0x04c11db7:0);
+		if(a&(1U<<i))
+			r^=b;
+	}
+	return r;
+}
+
+/**
+ * x^(8*2^i) mod P, for shifting CRC over 2^i bytes.
+ */
+struct crc_shift_table
+{
+	uint32_t shift[32];
+	constexpr crc_shift_table():shift()
+	{
+		uint32_t r=0x100; //x^8
+		for(int i=0;i<32;i++)
+		{
+			shift[i]=r;
+			r=crc_mulmod(r,r);
+		}
+	}
+};
+static constexpr crc_shift_table crc_shifts;
+
+/**
+ * crc*x^(8*len) mod P, as if len zero bytes were appended without initial value.
+ */
+static uint32_t crc_shift(uint32_t crc, uint32_t len)
+{
+	for(int i=0;len!=0;i++,len>>=1)
+		if(len&1)
+			crc=crc_mulmod(crc,crc_shifts.shift[i]);
+	return crc;
+}
+
+uint32_t dvb_crc32_combine(uint32_t crc_a, uint32_t crc_b, int len_b)
+{
+	//initial value of b is replaced by state after a
+	return crc_shift(crc_a^0xffffffff,len_b)^crc_b;
+}
+
+uint32_t dvb_crc32_patch(uint32_t crc, int len, int offset, const uint8_t *delta, int delta_len)
+{
+	return crc^crc_shift(dvb_crc32_update(0,delta,delta_len),len-offset-delta_len);
+}
+
 }
@@ -0,0 +1,266 @@
+/**
+ * \file
+ * Demultiplexing of PSI/SI PIDs from transport stream.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "inc/demux.h"
+#include "inc/crc.h"
+
+#define TS_PACKET_LEN 188
+#define TS_PID_COUNT 8192
+
+class psi_demux_impl: public psi_demux
+{
+public:
+	psi_demux_impl(size_t max_section_size,int max_dbg);
+	~psi_demux_impl();
+	void ts_packet(const uint8_t* packet);
+	void ts_packets(const uint8_t* packets, size_t n, size_t stride);
+	void on_section_ready(void* ctx, section_ready callback);
+	void add_pid(uint16_t pid);
+	void remove_pid(uint16_t pid);
+	bool has_pid(uint16_t pid);
+	void set_follow_pat(bool follow);
+	void set_crc_check(psi_extractor::crc_check mode);
+private:
+	struct pid_state
+	{
+		psi_demux_impl* demux;
+		uint16_t pid;
+		psi_extractor* extractor;
+	};
+	inline bool selected(const uint8_t* p, uint16_t* pid);
+	bool select_pid(uint16_t pid);
+	void deselect_pid(uint16_t pid);
+	static void on_extractor_section(void* ctx, const uint8_t* section, size_t size, bool crc_ok);
+	void follow_pat(const uint8_t* section, size_t size);
+	size_t		  max_section_size;
+	int			  max_dbg;
+	section_ready callback;
+	void*		  callback_ctx;
+	bool		  follow;
+	psi_extractor::crc_check crc_mode;
+	uint64_t	  filter[TS_PID_COUNT/64];
+	pid_state*	  pids[TS_PID_COUNT];
+	//PMT PIDs selected by follow_pat, and the ones listed in PAT version being collected
+	uint64_t	  pat_owned[TS_PID_COUNT/64];
+	uint64_t	  pat_listed[TS_PID_COUNT/64];
+	uint64_t	  pat_sections[256/64];
+	int			  pat_version;
+	bool		  pat_complete;
+};
+
+psi_demux* psi_demux::create(size_t max_section_size,int max_dbg)
+{
+	return new psi_demux_impl(max_section_size,max_dbg);
+}
+
+psi_demux_impl::psi_demux_impl(size_t max_section_size,int max_dbg)
+{
+	this->max_section_size=max_section_size;
+	this->max_dbg=max_dbg;
+	callback=NULL;
+	callback_ctx=NULL;
+	follow=false;
+	crc_mode=psi_extractor::crc_none;
+	memset(filter,0,sizeof(filter));
+	memset(pids,0,sizeof(pids));
+	memset(pat_owned,0,sizeof(pat_owned));
+	memset(pat_listed,0,sizeof(pat_listed));
+	memset(pat_sections,0,sizeof(pat_sections));
+	pat_version=-1;
+	pat_complete=false;
+	const uint16_t si_pids[]={0x00,0x01,0x10,0x11,0x12,0x14};
+	for(size_t i=0;i<sizeof(si_pids)/sizeof(*si_pids);i++)
+		add_pid(si_pids[i]);
+}
+
+psi_demux_impl::~psi_demux_impl()
+{
+	for(int pid=0;pid<TS_PID_COUNT;pid++)
+		deselect_pid(pid);
+}
+
+inline bool psi_demux_impl::selected(const uint8_t* p, uint16_t* pid)
+{
+	*pid=(p[1]<<8 | p[2]) & (TS_PID_COUNT-1);
+	if((filter[*pid/64]&(1ULL<<(*pid%64)))==0)
+		return false;
+	if(p[0]!=0x47 || (p[1]&0x80)!=0)
+		return false; //lost sync or transport_error_indicator
+	return true;
+}
+
+void psi_demux_impl::ts_packet(const uint8_t* p)
+{
+	uint16_t pid;
+	if(selected(p,&pid))
+		pids[pid]->extractor->ts_packet(p);
+}
+
+void psi_demux_impl::ts_packets(const uint8_t* packets, size_t n, size_t stride)
+{
+	const uint8_t* run=NULL;
+	size_t run_len=0;
+	uint16_t run_pid=0;
+	for(size_t i=0;i<n;i++)
+	{
+		const uint8_t* p=packets+i*stride;
+		__builtin_prefetch(p+8*stride);
+		uint16_t pid=(p[1]<<8 | p[2]) & (TS_PID_COUNT-1);
+		if(run_len!=0 && pid==run_pid && p[0]==0x47 && (p[1]&0x80)==0)
+		{
+			run_len++;
+			continue;
+		}
+		//run is passed before filter is checked, its sections may add PIDs
+		if(run_len!=0)
+			pids[run_pid]->extractor->ts_packets(run,run_len,stride);
+		run_len=0;
+		if(selected(p,&pid))
+		{
+			run=p;
+			run_len=1;
+			run_pid=pid;
+		}
+	}
+	if(run_len!=0)
+		pids[run_pid]->extractor->ts_packets(run,run_len,stride);
+}
+
+void psi_demux_impl::on_section_ready(void* ctx, section_ready callback)
+{
+	this->callback=callback;
+	this->callback_ctx=ctx;
+}
+
+void psi_demux_impl::add_pid(uint16_t pid)
+{
+	pid&=TS_PID_COUNT-1;
+	//PID selected by user is no longer dropped with PAT
+	pat_owned[pid/64]&=~(1ULL<<(pid%64));
+	select_pid(pid);
+}
+
+void psi_demux_impl::remove_pid(uint16_t pid)
+{
+	pid&=TS_PID_COUNT-1;
+	pat_owned[pid/64]&=~(1ULL<<(pid%64));
+	deselect_pid(pid);
+}
+
+/**
+ * Creates extractor for PID.
+ * \return false if PID was already selected
+ */
+bool psi_demux_impl::select_pid(uint16_t pid)
+{
+	if(pids[pid]!=NULL)
+		return false;
+	pid_state* s=new pid_state;
+	s->demux=this;
+	s->pid=pid;
+	s->extractor=psi_extractor::create(max_section_size,max_dbg);
+	s->extractor->set_crc_check(crc_mode);
+	s->extractor->on_section_ready(s,on_extractor_section);
+	pids[pid]=s;
+	filter[pid/64]|=1ULL<<(pid%64);
+	return true;
+}
+
+void psi_demux_impl::deselect_pid(uint16_t pid)
+{
+	if(pids[pid]==NULL)
+		return;
+	filter[pid/64]&=~(1ULL<<(pid%64));
+	delete pids[pid]->extractor;
+	delete pids[pid];
+	pids[pid]=NULL;
+}
+
+bool psi_demux_impl::has_pid(uint16_t pid)
+{
+	pid&=TS_PID_COUNT-1;
+	return (filter[pid/64]&(1ULL<<(pid%64)))!=0;
+}
+
+void psi_demux_impl::set_follow_pat(bool follow)
+{
+	this->follow=follow;
+}
+
+void psi_demux_impl::set_crc_check(psi_extractor::crc_check mode)
+{
+	crc_mode=mode;
+	for(int pid=0;pid<TS_PID_COUNT;pid++)
+		if(pids[pid]!=NULL)
+			pids[pid]->extractor->set_crc_check(mode);
+}
+
+void psi_demux_impl::on_extractor_section(void* ctx, const uint8_t* section, size_t size, bool crc_ok)
+{
+	pid_state* s=(pid_state*)ctx;
+	psi_demux_impl* d=s->demux;
+	if(d->callback!=NULL)
+		d->callback(d->callback_ctx,s->pid,section,size,crc_ok);
+	if(d->follow && s->pid==0 && crc_ok)
+		d->follow_pat(section,size);
+}
+
+/**
+ * Adds program_map_PID of each program in PAT section.
+ * When all sections of new PAT version have been received, PIDs added for programs
+ * that are no longer listed are removed.
+ */
+void psi_demux_impl::follow_pat(const uint8_t* section, size_t size)
+{
+	//table_id 0, 8 bytes of header, 4 bytes for each program, CRC_32
+	if(size<12 || section[0]!=0x00)
+		return;
+	//crc_ok is also true when CRC is not checked, and corrupted PAT would select random PIDs
+	if(mopa::dvb_crc32(section,size)!=0)
+		return;
+	if((section[5]&0x01)==0)
+		return; //not applicable yet
+	int version=(section[5]>>1)&0x1f;
+	uint8_t section_number=section[6];
+	uint8_t last_section_number=section[7];
+	if(version!=pat_version)
+	{
+		pat_version=version;
+		pat_complete=false;
+		memset(pat_listed,0,sizeof(pat_listed));
+		memset(pat_sections,0,sizeof(pat_sections));
+	}
+	for(size_t i=8;i+4<=size-4;i+=4)
+	{
+		uint16_t program_number=section[i]<<8 | section[i+1];
+		uint16_t pid=(section[i+2]<<8 | section[i+3]) & (TS_PID_COUNT-1);
+		if(program_number==0)
+			continue;
+		pat_listed[pid/64]|=1ULL<<(pid%64);
+		if(select_pid(pid))
+			pat_owned[pid/64]|=1ULL<<(pid%64);
+	}
+	pat_sections[section_number/64]|=1ULL<<(section_number%64);
+	if(pat_complete)
+		return;
+	for(int n=0;n<=last_section_number;n++)
+		if((pat_sections[n/64]&(1ULL<<(n%64)))==0)
+			return;
+	pat_complete=true;
+	for(int w=0;w<TS_PID_COUNT/64;w++)
+	{
+		uint64_t gone=pat_owned[w]&~pat_listed[w];
+		pat_owned[w]&=~gone;
+		while(gone!=0)
+		{
+			int b=__builtin_ctzll(gone);
+			gone&=gone-1;
+			deselect_pid(w*64+b);
+		}
+	}
+}
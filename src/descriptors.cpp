@@ -7,9 +7,9 @@ descriptor* descriptor_factory(uint8_t tag)
 	descriptor* dst=NULL;
 	switch(tag)
 	{
-		case 0x41:  dst=new service_list_descriptor(); break;
-		case 0x44:	dst=new cable_delivery_system_descriptor(); break;
-		case 0x70:	dst=new adaptation_field_data_descriptor(); break;
+#define DVB_DESCRIPTOR_NEW(tag,type) case tag: dst=new type(); break;
+		DVB_DESCRIPTORS(DVB_DESCRIPTOR_NEW)
+#undef DVB_DESCRIPTOR_NEW
 
 		default:	dst=new unknown_descriptor(); break;
 	}
@@ -41,40 +41,232 @@ descriptor_vector& descriptor_vector::operator=(descriptor_vector const &x)
 	//printf("=\n");return *this;
 };
 
-void descriptor_vector::io(iox& x)
+void descriptor_vector::purge()
 {
-	if(x.is_parsing())
+	for(int i=0;i<size();i++)
+		delete this->operator[](i);
+	clear();
+}
+
+lazy_descriptor_vector::lazy_descriptor_vector():raw(NULL)
+{
+}
+lazy_descriptor_vector::~lazy_descriptor_vector()
+{
+	purge();
+}
+lazy_descriptor_vector::lazy_descriptor_vector(const lazy_descriptor_vector& x):raw(NULL)
+{
+	*this=x;
+}
+lazy_descriptor_vector& lazy_descriptor_vector::operator=(lazy_descriptor_vector const &x)
+{
+	if(&x!=this)
 	{
 		purge();
-		while(x.block_size_left()>0)
+		raw=x.raw;
+		entries=x.entries;
+		for(size_t i=0;i<entries.size();i++)
+			if(entries[i].decoded!=NULL)
+				entries[i].decoded=entries[i].decoded->dup();
+	}
+	return *this;
+}
+void lazy_descriptor_vector::purge()
+{
+	for(size_t i=0;i<entries.size();i++)
+		delete entries[i].decoded;
+	entries.clear();
+	raw=NULL;
+}
+void lazy_descriptor_vector::push_back(descriptor* d)
+{
+	entry e;
+	e.offset=0;
+	e.tag=d->tag;
+	e.length=0;
+	e.decoded=d;
+	entries.push_back(e);
+}
+descriptor* lazy_descriptor_vector::at(size_t i)
+{
+	entry& e=entries[i];
+	if(e.decoded==NULL)
+	{
+		iox x;
+		x.reset(raw,e.offset+2+e.length);
+		x.ctx->bitpos=e.offset*8;
+		ibx y=x.as_ibx();
+		uint8_t tag;
+		y.uint<8>(DVB_VAR(tag));
+		descriptor* dsc=descriptor_factory(tag);
+		dsc->tag=tag;
+		try
 		{
-			//read tag ahead
-			uint8_t tag;
-			x.uint(8,DVB_VAR(tag));
-			descriptor* dsc=descriptor_factory(tag);
-			push_back(dsc);
-			dsc->tag=tag;
-			back()->io(x);
+			dsc->io(y);
+			if(y.ctx->bitpos!=(e.offset+2+e.length)*8)
+				throw Exception(y.ctx,DVB_INFO("descriptor"),ERR_BLOCK,"descriptor 0x%2.2x consumed %d bytes of %d",
+						tag,y.ctx->bitpos/8-e.offset-2,e.length);
 		}
+		catch(...)
+		{
+			delete dsc;
+			throw;
+		}
+		e.decoded=dsc;
 	}
-	else
+	return e.decoded;
+}
+descriptor* lazy_descriptor_vector::find(uint8_t tag, size_t from)
+{
+	for(size_t i=from;i<entries.size();i++)
+		if(entries[i].tag==tag)
+			return at(i);
+	return NULL;
+}
+
+void lazy_descriptor_vector::io(ibx& x)
+{
+	purge();
+	if((x.ctx->bitpos&7)!=0)
+	{
+		x.ctx->fail(DVB_INFO("descriptors"),ERR_ALIGNMENT,"descriptor loop not byte-aligned");
+		return;
+	}
+	raw=x.ctx->data;
+	while(x.block_size_left()>0)
 	{
-		for(size_t i=0;i<size();i++)
+		entry e;
+		e.offset=x.ctx->bitpos/8;
+		record<ibx> r(x,16,DVB_INFO("descriptor"));
+		r.uint<8>(e.tag,DVB_INFO("descriptor_tag"));
+		r.uint<8>(e.length,DVB_INFO("descriptor_length"));
+		if(e.length*8>x.block_size_left())
 		{
-			this->operator[](i)->io(x);
+			x.ctx->fail(DVB_INFO("descriptor_length"),ERR_NO_SPACE,"descriptor length %d exceeds available %d bytes",
+					e.length,x.block_size_left()/8);
+			return;
 		}
+		x.ctx->bitpos+=e.length*8;
+		e.decoded=NULL;
+		entries.push_back(e);
 	}
 }
-void descriptor_vector::purge()
+void lazy_descriptor_vector::io(obx& x)
 {
-	for(int i=0;i<size();i++)
-		delete this->operator[](i);
-	clear();
+	for(size_t i=0;i<entries.size();i++)
+	{
+		entry& e=entries[i];
+		if(e.decoded!=NULL)
+		{
+			e.decoded->io(x);
+			continue;
+		}
+		uint32_t len=2+e.length;
+		if((x.ctx->bitpos&7)!=0)
+			throw Exception(x.ctx,DVB_INFO("descriptor"),ERR_ALIGNMENT,"descriptor not byte-aligned");
+		if(x.ctx->bitpos+len*8>x.ctx->bitlimit)
+			throw Exception(x.ctx,DVB_INFO("descriptor"),ERR_NO_SPACE,"descriptor requires %d bytes, only %d bytes available",
+					len,(x.ctx->bitlimit-x.ctx->bitpos)/8);
+		memcpy(x.ctx->data+x.ctx->bitpos/8,raw+e.offset,len);
+		x.ctx->bitpos+=len*8;
+		x.ctx->advance();
+	}
 }
-
-
-
+void lazy_descriptor_vector::io(omx& x)
+{
+	for(size_t i=0;i<entries.size();i++)
+	{
+		entry& e=entries[i];
+		if(e.decoded!=NULL)
+		{
+			e.decoded->io(x);
+			continue;
+		}
+		uint32_t len=2+e.length;
+		if((x.ctx->bitpos&7)!=0)
+			throw Exception(x.ctx,DVB_INFO("descriptor"),ERR_ALIGNMENT,"descriptor not byte-aligned");
+		if(x.ctx->bitpos+len*8>x.ctx->bitlimit)
+			throw Exception(x.ctx,DVB_INFO("descriptor"),ERR_NO_SPACE,"descriptor requires %d bytes, only %d bytes available",
+					len,(x.ctx->bitlimit-x.ctx->bitpos)/8);
+		x.ctx->bitpos+=len*8;
+	}
+}
+void lazy_descriptor_vector::io(icx& x)
+{
+	purge();
+	while(x.block_size_left()>0)
+	{
+		//read tag ahead
+		uint8_t tag;
+		x.uint<8>(DVB_VAR(tag));
+		descriptor* dsc=descriptor_factory(tag);
+		dsc->tag=tag;
+		push_back(dsc);
+		dsc->io(x);
+	}
+}
+void lazy_descriptor_vector::io(ocx& x)
+{
+	for(size_t i=0;i<entries.size();i++)
+		at(i)->io(x);
+}
+void lazy_descriptor_vector::io(ipx& x)
+{
+	if(x.is_skipping())
+	{
+		purge();
+		return;
+	}
+	ibx y(x.ctx);
+	io(y);
+}
+void lazy_descriptor_vector::io(ivx& x)
+{
+	//same acceptance as descriptor_vector, so content of descriptors is checked
+	while(x.block_size_left()>0)
+	{
+		uint8_t tag;
+		x.uint<8>(DVB_VAR(tag));
+		descriptor_visit(tag,[&x,tag](descriptor& d){d.tag=tag;d.io(x);});
+	}
+}
+void lazy_descriptor_vector::io(iox& x)
+{
+	if(x.is_parsing())
+		if(x.is_validating())
+		{
+			ivx y=x.as_ivx();
+			io(y);
+		}
+		else if(x.is_binary())
+		{
+			ibx y=x.as_ibx();
+			io(y);
+		}
+		else
+		{
+			icx y=x.as_icx();
+			io(y);
+		}
+	else
+		if(x.is_measuring())
+		{
+			omx y=x.as_omx();
+			io(y);
+		}
+		else if(x.is_binary())
+		{
+			obx y=x.as_obx();
+			io(y);
+		}
+		else
+		{
+			ocx y=x.as_ocx();
+			io(y);
+		}
 }
 
 
 
+}
@@ -0,0 +1,215 @@
+/**
+ * \file
+ * Detection of TS packet size and sync byte positions.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "inc/framer.h"
+
+#define TS_PACKET_LEN 188
+#define TS_SYNC_BYTE 0x47
+/**
+ * Number of sync bytes at stride required to lock on.
+ */
+#define TS_SYNC_COUNT 5
+#define TS_MAX_STRIDE 204
+/**
+ * Bytes needed to test 16 positions for sync.
+ */
+#define TS_SYNC_WINDOW ((TS_SYNC_COUNT-1)*TS_MAX_STRIDE+16)
+
+static const size_t ts_strides[]={188,192,204};
+
+class ts_framer_impl: public ts_framer
+{
+public:
+	ts_framer_impl();
+	~ts_framer_impl();
+	void data(const uint8_t* bytes, size_t len);
+	void on_packets_ready(void* ctx, packets_ready callback);
+	size_t packet_size();
+	uint64_t skipped_bytes();
+	uint32_t sync_losses();
+private:
+	size_t process(const uint8_t* buf, size_t len);
+	bool find_sync(const uint8_t* buf, size_t len, size_t* pos);
+	packets_ready callback;
+	void*		  callback_ctx;
+	size_t		  stride; //0 when not synchronized
+	size_t		  skip; //rest of stride of last packet, not received yet
+	uint64_t	  skipped;
+	uint32_t	  losses;
+	std::vector<uint8_t> pending; //input not processed yet, shorter than TS_SYNC_WINDOW
+};
+
+ts_framer* ts_framer::create()
+{
+	return new ts_framer_impl();
+}
+
+ts_framer_impl::ts_framer_impl()
+{
+	callback=NULL;
+	callback_ctx=NULL;
+	stride=0;
+	skip=0;
+	skipped=0;
+	losses=0;
+}
+
+ts_framer_impl::~ts_framer_impl()
+{
+}
+
+void ts_framer_impl::on_packets_ready(void* ctx, packets_ready callback)
+{
+	this->callback=callback;
+	this->callback_ctx=ctx;
+}
+
+size_t ts_framer_impl::packet_size()
+{
+	return stride;
+}
+
+uint64_t ts_framer_impl::skipped_bytes()
+{
+	return skipped;
+}
+
+uint32_t ts_framer_impl::sync_losses()
+{
+	return losses;
+}
+
+/**
+ * Searches for first position from which TS_SYNC_COUNT sync bytes follow at one of strides.
+ * Positions are tested only if all of their sync bytes are within \b len.
+ * \param pos - in: where to start, out: sync found, or first position not tested
+ */
+bool ts_framer_impl::find_sync(const uint8_t* buf, size_t len, size_t* pos)
+{
+	size_t q=*pos;
+#ifdef __SSE2__
+	const __m128i sync=_mm_set1_epi8(TS_SYNC_BYTE);
+	for(;q+TS_SYNC_WINDOW<=len;q+=16)
+	{
+		uint32_t first=_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(buf+q)),sync));
+		if(first==0)
+			continue;
+		uint32_t best=32;
+		size_t best_stride=0;
+		for(size_t s=0;s<sizeof(ts_strides)/sizeof(*ts_strides);s++)
+		{
+			uint32_t m=first;
+			for(int k=1;k<TS_SYNC_COUNT && m!=0;k++)
+				m&=_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(buf+q+k*ts_strides[s])),sync));
+			if(m!=0 && (uint32_t)__builtin_ctz(m)<best)
+			{
+				best=__builtin_ctz(m);
+				best_stride=ts_strides[s];
+			}
+		}
+		if(best_stride!=0)
+		{
+			stride=best_stride;
+			*pos=q+best;
+			return true;
+		}
+	}
+#endif
+	for(;q+(TS_SYNC_COUNT-1)*TS_MAX_STRIDE<len;q++)
+	{
+		if(buf[q]!=TS_SYNC_BYTE)
+			continue;
+		for(size_t s=0;s<sizeof(ts_strides)/sizeof(*ts_strides);s++)
+		{
+			int k;
+			for(k=1;k<TS_SYNC_COUNT;k++)
+				if(buf[q+k*ts_strides[s]]!=TS_SYNC_BYTE)
+					break;
+			if(k==TS_SYNC_COUNT)
+			{
+				stride=ts_strides[s];
+				*pos=q;
+				return true;
+			}
+		}
+	}
+	*pos=q;
+	return false;
+}
+
+/**
+ * Passes packets found in \b buf.
+ * \return number of bytes consumed, what remains is shorter than needed to continue
+ */
+size_t ts_framer_impl::process(const uint8_t* buf, size_t len)
+{
+	size_t pos=skip<len?skip:len;
+	skip-=pos;
+	while(true)
+	{
+		if(stride==0)
+		{
+			size_t q=pos;
+			bool found=find_sync(buf,len,&q);
+			skipped+=q-pos;
+			pos=q;
+			if(!found)
+				return pos;
+		}
+		size_t run=pos;
+		size_t n=0;
+		while(pos+TS_PACKET_LEN<=len && buf[pos]==TS_SYNC_BYTE)
+		{
+			pos+=stride;
+			n++;
+		}
+		if(n!=0 && callback!=NULL)
+			callback(callback_ctx,buf+run,n,stride);
+		if(pos>len)
+		{
+			//timestamp or parity bytes of last packet are in next input
+			skip=pos-len;
+			return len;
+		}
+		if(pos+TS_PACKET_LEN<=len)
+		{
+			//sync byte missing
+			stride=0;
+			losses++;
+			continue;
+		}
+		return pos;
+	}
+}
+
+void ts_framer_impl::data(const uint8_t* bytes, size_t len)
+{
+	if(!pending.empty())
+	{
+		//complete pending input with enough bytes that it is consumed entirely
+		size_t old=pending.size();
+		size_t add=len<TS_SYNC_WINDOW?len:TS_SYNC_WINDOW;
+		pending.insert(pending.end(),bytes,bytes+add);
+		size_t used=process(&pending[0],pending.size());
+		if(used<old)
+		{
+			//all input is in pending and there is not enough of it
+			pending.erase(pending.begin(),pending.begin()+used);
+			return;
+		}
+		pending.clear();
+		bytes+=used-old;
+		len-=used-old;
+	}
+	size_t used=process(bytes,len);
+	pending.assign(bytes+used,bytes+len);
+}
@@ -3,65 +3,234 @@
  */
 #include "inc/io.h"
 #include <assert.h>
+#include <algorithm>
+#include <unistd.h>
+#include <errno.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace mopa
 {
 
 
+void text_sink_fd(void* sink_ctx, const char* text, size_t len)
+{
+	int fd=(intptr_t)sink_ctx;
+	while(len>0)
+	{
+		ssize_t r=write(fd,text,len);
+		if(r<0)
+		{
+			if(errno==EINTR) continue;
+			return;
+		}
+		text+=r;
+		len-=r;
+	}
+}
+void text_sink_file(void* sink_ctx, const char* text, size_t len)
+{
+	fwrite(text,1,len,(FILE*)sink_ctx);
+}
+
+void ocCtx::flush()
+{
+	if(sink==NULL || scope_stack.size()!=0 || prod.empty())
+		return;
+	sink(sink_ctx,prod.data(),prod.size());
+	prod.clear();
+	bitpos&=7;
+}
 void ocCtx::enter_scope(const iox_info* info)
 {
-	prod+=std::string(scope_stack.size()*2,' ');
-	prod+="{\n";
+	uint32_t depth=scope_stack.size();
+	char* p=line_space(depth*2+2);
+	if(p==NULL)
+	{
+		indent();
+		prod+="{\n";
+		return;
+	}
+	memset(p,' ',depth*2);
+	p[depth*2]='{';
+	p[depth*2+1]='\n';
+	lines_len+=depth*2+2;
 }
 void ocCtx::leave_scope(const iox_info* info)
 {
-	prod+=std::string(scope_stack.size()*2,' ');
-	prod+="}\n";
+	uint32_t depth=scope_stack.size();
+	char* p=line_space(depth*2+2);
+	if(p==NULL)
+	{
+		indent();
+		prod+="}\n";
+		return;
+	}
+	memset(p,' ',depth*2);
+	p[depth*2]='}';
+	p[depth*2+1]='\n';
+	lines_len+=depth*2+2;
 }
-void ocCtx::write_uint(int bitsize, uint32_t value, const iox_info* info)
+void ocCtx::write_uint(int bitsize, uint64_t value, const iox_info* info)
 {
-	if(bitsize<32 && value>(uint32_t)( (1<<bitsize)-1 )) throw Exception(this,info, "value %d exceeds %d bits",value,bitsize);
-	prod+=std::string(scope_stack.size()*2,' ');
-	prod+=info->name;
-	prod+=":";
-	uint32_t fmt=info->hint&FORMAT_HINT_MASK;
-	if(fmt==FORMAT_HINT_HEX)
+	uint32_t depth=scope_stack.size();
+	size_t name_len=strlen(info->name);
+	char* p=line_space(depth*2+name_len+68);
+	if(p==NULL)
 	{
-		write_hex(bitsize, value);
+		format_uint(prod,depth,bitsize,value,info);
+		chunk_done();
+		return;
 	}
-	else if(fmt==FORMAT_HINT_BIN)
+	if(bitsize<64 && value>( (1ULL<<bitsize)-1 )) throw Exception(this,info, ERR_VALUE,"value %llu exceeds %d bits",(unsigned long long)value,bitsize);
+	lines_len+=format_line(p,depth,bitsize,value,info,name_len)-p;
+}
+void ocCtx::insert_uint(uint32_t position, uint32_t depth, int bitsize, uint64_t value, const iox_info* info)
+{
+	ocInsertion i;
+	i.position=position;
+	i.offset=inserted.size();
+	format_uint(inserted,depth,bitsize,value,info);
+	i.length=inserted.size()-i.offset;
+	insertions.push_back(i);
+}
+void ocCtx::merge_insertions()
+{
+	if(insertions.empty())
+		return;
+	//blocks end innermost first, but begin outermost first
+	std::sort(insertions.begin(),insertions.end(),
+			[](const ocInsertion& a,const ocInsertion& b){return a.position<b.position;});
+	std::string out;
+	out.reserve(prod.size()+inserted.size());
+	uint32_t pos=0;
+	for(size_t k=0;k<insertions.size();k++)
 	{
-		write_bin(bitsize, value);
+		const ocInsertion& i=insertions[k];
+		out.append(prod,pos,i.position-pos);
+		out.append(inserted,i.offset,i.length);
+		pos=i.position;
 	}
-	else
+	out.append(prod,pos,std::string::npos);
+	prod.swap(out);
+	insertions.clear();
+	inserted.clear();
+}
+/**
+ * Lookup tables for formatting integers.
+ */
+struct format_lut
+{
+	char dec[100][2];	/**< "00".."99" */
+	char hex[16];		/**< digit of nibble */
+	char bin[256][8];	/**< bits of byte, most significant first */
+	uint64_t pow10[20];	/**< 1..10^19 */
+	constexpr format_lut():dec(),hex(),bin(),pow10()
 	{
-		write_dec(bitsize, value);
+		pow10[0]=1;
+		for(int i=1;i<20;i++)
+			pow10[i]=pow10[i-1]*10;
+		for(int i=0;i<100;i++)
+		{
+			dec[i][0]='0'+i/10;
+			dec[i][1]='0'+i%10;
+		}
+		for(int i=0;i<16;i++)
+			hex[i]=i<10?'0'+i:'a'+i-10;
+		for(int i=0;i<256;i++)
+			for(int j=0;j<8;j++)
+				bin[i][j]=(i&(0x80>>j))?'1':'0';
 	}
-	prod+="\n";
+};
+static constexpr format_lut lut;
+
+void ocCtx::format_uint(std::string& out, uint32_t depth, int bitsize, uint64_t value, const iox_info* info)
+{
+	if(bitsize<64 && value>( (1ULL<<bitsize)-1 )) throw Exception(this,info, ERR_VALUE,"value %llu exceeds %d bits",(unsigned long long)value,bitsize);
+	size_t name_len=strlen(info->name);
+	size_t pos=out.size();
+	out.resize(pos+depth*2+name_len+68);
+	out.resize(format_line(&out[pos],depth,bitsize,value,info,name_len)-out.data());
+}
+char* ocCtx::format_line(char* p, uint32_t depth, int bitsize, uint64_t value, const iox_info* info, size_t name_len)
+{
+	memset(p,' ',depth*2);
+	p+=depth*2;
+	memcpy(p,info->name,name_len);
+	p+=name_len;
+	*p++=':';
+	uint32_t fmt=info->hint&FORMAT_HINT_MASK;
+	if(fmt==FORMAT_HINT_HEX)
+		p+=write_hex(p, bitsize, value);
+	else if(fmt==FORMAT_HINT_BIN)
+		p+=write_bin(p, bitsize, value);
+	else
+		p+=write_dec(p, bitsize, value);
+	*p++='\n';
+	return p;
 }
 
-void ocCtx::write_hex(int bitsize, uint32_t value)
+int ocCtx::write_hex(char* buf, int, uint64_t value)
 {
-	char buf[11];
-	sprintf(buf,"0x%x",value);
-	prod+=buf;
+	int digits=value==0?1:(67-__builtin_clzll(value))/4;
+	buf[0]='0';
+	buf[1]='x';
+	for(int i=digits+1;i>=2;i--)
+	{
+		buf[i]=lut.hex[value&0xf];
+		value>>=4;
+	}
+	return 2+digits;
 }
-void ocCtx::write_bin(int bitsize, uint32_t value)
+int ocCtx::write_bin(char* buf, int bitsize, uint64_t value)
 {
-	char buf[33];
-	int i;
-	for(i=0;i<bitsize;i++)
+	char* p=buf;
+	*p++='0';
+	*p++='b';
+	int head=bitsize&7;
+	if(head!=0)
+	{
+		memcpy(p,lut.bin[(value>>(bitsize-head))&0xff]+8-head,head);
+		p+=head;
+	}
+	for(int shift=bitsize-head-8;shift>=0;shift-=8)
 	{
-		if(value&(1<<(bitsize-1-i))) buf[i]='0'; else buf[i]='1';
+		memcpy(p,lut.bin[(value>>shift)&0xff],8);
+		p+=8;
 	}
-	buf[bitsize]=0;
-	prod+=buf;
+	return p-buf;
 }
-void ocCtx::write_dec(int bitsize, uint32_t value)
+int ocCtx::write_dec(char* buf, int, uint64_t value)
 {
-	char buf[12];
-	sprintf(buf,"%d",value);
-	prod+=buf;
+	int len;
+	if(value<100)
+		len=value<10?1:2;
+	else if(value<10000)
+		len=value<1000?3:4;
+	else
+	{
+		len=5;
+		while(len<20 && value>=lut.pow10[len])
+			len++;
+	}
+	char* p=buf+len;
+	while(value>=100)
+	{
+		const char* d=lut.dec[value%100];
+		p-=2;
+		p[0]=d[0];
+		p[1]=d[1];
+		value/=100;
+	}
+	if(value>=10)
+	{
+		p[-2]=lut.dec[value][0];
+		p[-1]=lut.dec[value][1];
+	}
+	else
+		p[-1]='0'+value;
+	return len;
 }
 
 
@@ -76,33 +245,73 @@ void icCtx::leave_scope(const iox_info* info)
 bool icCtx::expect(const char* req)
 {
 	skiptotoken();
-	while((*req!=0) && (*parse_pos==*req))
+	while((*req!=0) && parse_pos<parse_end && (*parse_pos==*req))
 	{
 		parse_pos++;
 		req++;
 	}
 	return(*req==0);//all req was matched
 }
+/**
+ * Advances line index over newlines of 16 bytes at \b p, marked in \b newline_mask.
+ */
+void icCtx::count_lines(const char* p, uint32_t newline_mask)
+{
+	if(newline_mask==0)
+		return;
+	line_nr+=__builtin_popcount(newline_mask);
+	line_begin=p+(31-__builtin_clz(newline_mask))+1;
+}
 bool icCtx::skiptotoken()
 {
-	while((*parse_pos=='\t') || (*parse_pos=='\n') || (*parse_pos==' '))
-		parse_pos++;
-	return(*parse_pos!=0); //there is something more to read
+#ifdef __SSE2__
+	const __m128i space=_mm_set1_epi8(' ');
+	const __m128i tab=_mm_set1_epi8('\t');
+	const __m128i newline=_mm_set1_epi8('\n');
+	while(parse_end-parse_pos>=16)
+	{
+		__m128i c=_mm_loadu_si128((const __m128i*)parse_pos);
+		__m128i nl=_mm_cmpeq_epi8(c,newline);
+		__m128i ws=_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c,space),_mm_cmpeq_epi8(c,tab)),nl);
+		uint32_t ws_mask=_mm_movemask_epi8(ws);
+		uint32_t nl_mask=_mm_movemask_epi8(nl);
+		if(ws_mask!=0xffff)
+		{
+			uint32_t n=__builtin_ctz(~ws_mask);
+			count_lines(parse_pos,nl_mask&((1U<<n)-1));
+			parse_pos+=n;
+			return true;
+		}
+		count_lines(parse_pos,nl_mask);
+		parse_pos+=16;
+	}
+#endif
+	while(parse_pos<parse_end && ((*parse_pos=='\t') || (*parse_pos=='\n') || (*parse_pos==' ')))
+		next_char();
+	return(parse_pos<parse_end); //there is something more to read
 }
 
-uint32_t icCtx::read_uint(int bitsize,  const iox_info* info)
+uint64_t icCtx::read_uint(int bitsize,  const iox_info* info)
 {
-	uint32_t value;
-	if(!expect(info->name)) throw Exception(this,info,"'%s' expected",info->name);
-	if(!expect(":")) throw Exception(this,info,"':' expected");
+	uint64_t value;
+	if(!expect(info->name))
+	{
+		fail(info,ERR_SYNTAX,"'%s' expected",info->name);
+		return 0;
+	}
+	if(!expect(":"))
+	{
+		fail(info,ERR_SYNTAX,"':' expected");
+		return 0;
+	}
 	skiptotoken();
-	if(*parse_pos=='0' && *(parse_pos+1)=='x')
+	if(peek()=='0' && peek(1)=='x')
 	{
 		parse_pos+=2;
 		value=read_hex(bitsize,info);
 		goto done;
 	}
-	if(*parse_pos=='0' && *(parse_pos+1)=='b')
+	if(peek()=='0' && peek(1)=='b')
 	{
 		parse_pos+=2;
 		value=read_bin(bitsize,info);
@@ -113,71 +322,135 @@ uint32_t icCtx::read_uint(int bitsize,  const iox_info* info)
 	return value;
 }
 
-
-uint32_t icCtx::read_hex(int bitsize,const iox_info* info)
+/**
+ * Value of hexadecimal digit, 0xff if character is not a digit.
+ */
+struct hex_lut
 {
-	uint64_t value=0;
-	do
+	uint8_t digit[256];
+	constexpr hex_lut():digit()
 	{
-		if(value>=0x100000000ULL) throw Exception(this,info,"value exceeds 32 bit");
-		if(*parse_pos>='0' && *parse_pos<='9')
+		for(int i=0;i<256;i++)
+			digit[i]=0xff;
+		for(int i=0;i<10;i++)
+			digit['0'+i]=i;
+		for(int i=0;i<6;i++)
 		{
-			value=value*16+*parse_pos-'0';
-			parse_pos++;
-			continue;
+			digit['a'+i]=10+i;
+			digit['A'+i]=10+i;
 		}
-		if(*parse_pos>='A' && *parse_pos<='F')
-		{
-			value=value*16+*parse_pos-'A';
-			parse_pos++;
-			continue;
-		}
-		if(*parse_pos>='a' && *parse_pos<='f')
+	}
+};
+static constexpr hex_lut hex_digits;
+
+/**
+ * Converts 8 decimal digits at once.
+ */
+static inline uint32_t parse_8_digits(const char* p)
+{
+	uint64_t w;
+	memcpy(&w,p,sizeof(w));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	w=__builtin_bswap64(w);
+#endif
+	w-=0x3030303030303030ULL;
+	w=(w*10)+(w>>8);
+	w=(((w&0x000000FF000000FFULL)*(100+(1000000ULL<<32)))+
+			(((w>>16)&0x000000FF000000FFULL)*(1+(10000ULL<<32))))>>32;
+	return w;
+}
+
+uint64_t icCtx::read_hex(int bitsize,const iox_info* info)
+{
+	uint64_t value=0;
+	//16 digits cannot overflow, they are converted without checks
+	const char* p=parse_pos;
+	const char* fast_end=parse_end-p>16?p+16:parse_end;
+	uint32_t digit;
+	while(p<fast_end && (digit=hex_digits.digit[(uint8_t)*p])!=0xff)
+	{
+		value=value*16+digit;
+		p++;
+	}
+	parse_pos=p;
+	while(parse_pos<parse_end && (digit=hex_digits.digit[(uint8_t)*parse_pos])!=0xff)
+	{
+		if(value>=0x1000000000000000ULL)
 		{
-			value=value*16+*parse_pos-'a';
-			parse_pos++;
-			continue;
+			fail(info,ERR_VALUE,"value exceeds 64 bit");
+			return 0;
 		}
-		break;
+		value=value*16+digit;
+		parse_pos++;
+	}
+	if(bitsize<64 && value >= (0x1ULL<<bitsize))
+	{
+		fail(info,ERR_VALUE,"value %llx exceeds %d bit",(unsigned long long)value,bitsize);
+		return 0;
 	}
-	while(true);
-	if(value >= (0x1ULL<<bitsize)) throw Exception(this,info,"value %x exceeds %d bit",value,bitsize);
 	return value;
 }
-uint32_t icCtx::read_bin(int bitsize,const iox_info* info)
+uint64_t icCtx::read_bin(int bitsize,const iox_info* info)
 {
 	uint64_t value=0;
-	do
+	//64 digits cannot overflow, they are converted without checks
+	const char* p=parse_pos;
+	const char* fast_end=parse_end-p>64?p+64:parse_end;
+	while(p<fast_end && (*p=='0' || *p=='1'))
+	{
+		value=value*2+*p-'0';
+		p++;
+	}
+	parse_pos=p;
+	while(parse_pos<parse_end && (*parse_pos=='0' || *parse_pos=='1'))
 	{
-		if(value>=0x100000000ULL) throw Exception(this,info,"value exceeds 32 bit");
-		if(*parse_pos>='0' && *parse_pos<='1')
+		if(value>=0x8000000000000000ULL)
 		{
-			value=value*2+*parse_pos-'0';
-			parse_pos++;
-			continue;
+			fail(info,ERR_VALUE,"value exceeds 64 bit");
+			return 0;
 		}
-		break;
+		value=value*2+*parse_pos-'0';
+		parse_pos++;
+	}
+	if(bitsize<64 && value >= (0x1ULL<<bitsize))
+	{
+		fail(info,ERR_VALUE,"value %llu exceeds %d bit",(unsigned long long)value,bitsize);
+		return 0;
 	}
-	while(true);
-	if(value >= (0x1ULL<<bitsize)) throw Exception(this,info,"value %d exceeds %d bit",value,bitsize);
 	return value;
 }
-uint32_t icCtx::read_dec(int bitsize,const iox_info* info)
+uint64_t icCtx::read_dec(int bitsize,const iox_info* info)
 {
 	uint64_t value=0;
-	do
+	//19 digits cannot overflow, they are converted without checks, 8 at a time
+	const char* p=parse_pos;
+	const char* fast_end=parse_end-p>19?p+19:parse_end;
+	const char* q=p;
+	while(q<fast_end && *q>='0' && *q<='9')
+		q++;
+	while(q-p>=8)
+	{
+		value=value*100000000+parse_8_digits(p);
+		p+=8;
+	}
+	while(p<q)
+		value=value*10+*p++-'0';
+	parse_pos=p;
+	while(parse_pos<parse_end && *parse_pos>='0' && *parse_pos<='9')
 	{
-		if(value>=0x100000000ULL) throw Exception(this,info,"value exceeds 32 bit");
-		if(*parse_pos>='0' && *parse_pos<='9')
+		if(value>(UINT64_MAX-(*parse_pos-'0'))/10)
 		{
-			value=value*10+*parse_pos-'0';
-			parse_pos++;
-			continue;
+			fail(info,ERR_VALUE,"value exceeds 64 bit");
+			return 0;
 		}
-		break;
+		value=value*10+*parse_pos-'0';
+		parse_pos++;
+	}
+	if(bitsize<64 && value >= (0x1ULL<<bitsize))
+	{
+		fail(info,ERR_VALUE,"value %llu exceeds %d bits",(unsigned long long)value,bitsize);
+		return 0;
 	}
-	while(true);
-	if(value >= (0x1ULL<<bitsize)) throw Exception(this,info,"value %d exceeds %d bits",(uint32_t)value,bitsize);
 	return value;
 }
 
@@ -187,118 +460,246 @@ uint32_t icCtx::read_dec(int bitsize,const iox_info* info)
 
 iox::iox()
 {
-	ibCtx* x=new ibCtx();
-	x->binary=true;
-	x->parsing=true;
-	x->data=NULL;
-	x->bitlimit=0;
-	x->bitpos=0;
-	ctx=x;
+	create(true,true);
 };
-iox::iox(iox const &from)
-{
-	ibCtx* x=new ibCtx();
-	x->binary=true;
-	x->parsing=true;
-	x->data=NULL;
-	x->bitlimit=0;
-	x->bitpos=0;
-	ctx=x;
-	*this=from;
-}
-iox::iox(ioCtx* ctx)
+iox::iox(iox&& from)
 {
-	this->ctx=ctx;
+	move_from(from);
 }
-iox& iox::operator=(iox const &rhs)
+iox& iox::operator=(iox&& rhs)
 {
 	if(this!=&rhs)
 	{
-		this->~iox();
-		if(rhs.ctx->parsing)
-			if(rhs.ctx->binary)
-			{
-				ctx=new ibCtx();
-				*(ibCtx*)ctx=*(ibCtx*)rhs.ctx;
-			}
-			else
-			{
-				ctx=new icCtx();
-				*(icCtx*)ctx=*(icCtx*)rhs.ctx;
-			}
-		else
-			if(rhs.ctx->binary)
-			{
-				ctx=new obCtx();
-				*(obCtx*)ctx=*(obCtx*)rhs.ctx;
-			}
-			else
-			{
-				ctx=new ocCtx();
-				*(ocCtx*)ctx=*(ocCtx*)rhs.ctx;
-			}
+		destroy();
+		move_from(rhs);
 	}
 	return *this;
 }
 iox::~iox()
+{
+	destroy();
+}
+
+void iox::create(bool parsing, bool binary)
+{
+	if(parsing)
+		if(binary)
+		{
+			ibCtx* x=new(&store.ib) ibCtx();
+			x->data=NULL;
+			x->data_size=0;
+			x->bitlimit=0;
+			ctx=x;
+		}
+		else
+		{
+			icCtx* x=new(&store.ic) icCtx();
+			x->parsed_text="";
+			x->parse_pos=x->parsed_text;
+			x->parse_end=x->parsed_text;
+			x->line_nr=1;
+			x->line_begin=x->parsed_text;
+			x->bitlimit=MOPA_TEXT_PARSE_BITLIMIT;
+			ctx=x;
+		}
+	else
+		if(binary)
+		{
+			obCtx* x=new(&store.ob) obCtx();
+			x->data=NULL;
+			x->data_size=0;
+			x->bitlimit=0;
+			ctx=x;
+		}
+		else
+		{
+			ocCtx* x=new(&store.oc) ocCtx();
+			x->bitlimit=8*1000000;
+			x->sink=NULL;
+			x->sink_ctx=NULL;
+			x->chunk_size=MOPA_TEXT_CHUNK;
+			x->lines.resize(MOPA_TEXT_LINES);
+			x->lines_len=0;
+			ctx=x;
+		}
+	ctx->parsing=parsing;
+	ctx->binary=binary;
+	ctx->validating=false;
+	ctx->measuring=false;
+	ctx->nothrow=false;
+	ctx->failed=false;
+	ctx->bitpos=0;
+}
+void iox::move_from(iox& from)
+{
+	if(from.ctx->parsing)
+		if(from.ctx->binary)
+			ctx=new(&store.ib) ibCtx(std::move(from.store.ib));
+		else
+			ctx=new(&store.ic) icCtx(std::move(from.store.ic));
+	else
+		if(from.ctx->binary)
+			ctx=new(&store.ob) obCtx(std::move(from.store.ob));
+		else
+		{
+			ctx=new(&store.oc) ocCtx(std::move(from.store.oc));
+			from.store.oc.sink=NULL;
+		}
+}
+void iox::destroy()
 {
 	if(ctx->parsing)
 		if(ctx->binary)
-			delete (ibCtx*)ctx;
+			store.ib.~ibCtx();
 		else
-			delete (icCtx*)ctx;
+			store.ic.~icCtx();
 	else
 		if(ctx->binary)
-			delete (obCtx*)ctx;
+			store.ob.~obCtx();
 		else
-			delete (ocCtx*)ctx;
+		{
+			store.oc.flush();
+			store.oc.~ocCtx();
+		}
 }
 
-iox iox::parse_binary(const uint8_t* data, uint32_t size)
+void iox::reset(const uint8_t* data, uint32_t size)
 {
-	ibCtx* x=new ibCtx();
-	x->binary=true;
-	x->parsing=true;
+	if(!ctx->parsing || !ctx->binary)
+	{
+		destroy();
+		create(true,true);
+	}
+	ibCtx* x=&store.ib;
+	x->validating=false;
+	x->scope_stack.clear();
 	x->data=data;
+	x->data_size=size;
 	x->bitlimit=size*8;
 	x->bitpos=0;
-	iox v(x);
-	//v.ctx=x;
-	return v;
+	x->refill();
 }
-iox iox::parse_text(const char* text)
+void iox::reset_validate(const uint8_t* data, uint32_t size)
 {
-	icCtx* x=new icCtx();
-	x->binary=false;
-	x->parsing=true;
+	reset(data,size);
+	ctx->validating=true;
+}
+void iox::reset_construct(uint8_t* data, uint32_t size)
+{
+	if(ctx->parsing || !ctx->binary)
+	{
+		destroy();
+		create(false,true);
+	}
+	obCtx* x=&store.ob;
+	x->measuring=false;
+	x->scope_stack.clear();
+	x->data=data;
+	x->data_size=size;
+	x->bitlimit=size*8;
+	x->bitpos=0;
+	x->acc=0;
+	x->acc_pos=0;
+	x->wpos=0;
+}
+void iox::reset_measure(uint32_t size)
+{
+	reset_construct(NULL,0);
+	ctx->bitlimit=size*8;
+	ctx->measuring=true;
+}
+void iox::reset(const char* text)
+{
+	reset(text,strlen(text));
+}
+void iox::reset(const char* text, size_t len)
+{
+	if(!ctx->parsing || ctx->binary)
+	{
+		destroy();
+		create(true,false);
+	}
+	icCtx* x=&store.ic;
+	x->scope_stack.clear();
 	x->parsed_text=text;
 	x->parse_pos=text;
+	x->parse_end=text+len;
+	x->line_nr=1;
+	x->line_begin=text;
+	x->bitpos=0;
+	x->bitlimit=MOPA_TEXT_PARSE_BITLIMIT;
+}
+void iox::reset_construct_text()
+{
+	reset_construct_text(NULL,NULL);
+}
+void iox::reset_construct_text(text_sink sink, void* sink_ctx, uint32_t chunk_size)
+{
+	if(ctx->parsing || ctx->binary)
+	{
+		destroy();
+		create(false,false);
+	}
+	ocCtx* x=&store.oc;
+	x->flush();
+	x->sink=sink;
+	x->sink_ctx=sink_ctx;
+	x->chunk_size=chunk_size;
+	x->scope_stack.clear();
+	x->prod.clear();
+	x->lines_len=0;
+	x->insertions.clear();
+	x->inserted.clear();
 	x->bitpos=0;
 	x->bitlimit=8*1000000;
-	iox v(x);
+}
+
+iox iox::parse_binary(const uint8_t* data, uint32_t size)
+{
+	iox v;
+	v.reset(data,size);
+	return v;
+}
+iox iox::parse_text(const char* text)
+{
+	iox v;
+	v.reset(text);
+	return v;
+}
+iox iox::parse_text(const char* text, size_t len)
+{
+	iox v;
+	v.reset(text,len);
 	return v;
 }
 iox iox::construct_binary(uint8_t* data, uint32_t size)
 {
-	obCtx* x=new obCtx();
-	x->binary=true;
-	x->parsing=false;
-	x->data=data;
-	x->bitlimit=size*8;
-	x->bitpos=0;
-	iox v(x);
-	//v.ctx=x;
+	iox v;
+	v.reset_construct(data,size);
 	return v;
 }
 iox iox::construct_text()
 {
-	ocCtx* x=new ocCtx();
-	x->binary=false;
-	x->parsing=false;
-	x->bitlimit=8*1000000;
-	x->bitpos=0;
-	iox v(x);
-	//v.ctx=x;
+	iox v;
+	v.reset_construct_text();
+	return v;
+}
+iox iox::construct_text(text_sink sink, void* sink_ctx, uint32_t chunk_size)
+{
+	iox v;
+	v.reset_construct_text(sink,sink_ctx,chunk_size);
+	return v;
+}
+iox iox::validate_binary(const uint8_t* data, uint32_t size)
+{
+	iox v;
+	v.reset_validate(data,size);
+	return v;
+}
+iox iox::measure_binary(uint32_t size)
+{
+	iox v;
+	v.reset_measure(size);
 	return v;
 }
 
@@ -323,6 +724,18 @@ obx iox::as_obx()
 {
 	return obx((obCtx*)ctx);
 }
+ivx iox::as_ivx()
+{
+	return ivx((ibCtx*)ctx);
+}
+ipx iox::as_ipx(uint32_t keep_depth)
+{
+	return ipx((ibCtx*)ctx,keep_depth);
+}
+omx iox::as_omx()
+{
+	return omx((obCtx*)ctx);
+}
 ocx iox::as_ocx()
 {
 	return ocx((ocCtx*)ctx);
@@ -350,6 +763,13 @@ void iox::uint(int bitsize,uint32_t& val,const iox_info* info)
 	else
 		as_ox().uint(bitsize,val,info);
 }
+void iox::uint(int bitsize,uint64_t& val,const iox_info* info)
+{
+	if(ctx->is_parsing())
+		val=as_ix().uint64(bitsize,info);
+	else
+		as_ox().uint(bitsize,val,info);
+}
 void iox::uint_req(int bitsize,uint8_t val,const iox_info* info)
 {
 	if(ctx->is_parsing())
@@ -358,7 +778,7 @@ void iox::uint_req(int bitsize,uint8_t val,const iox_info* info)
 		v=as_ix().uint8(bitsize,info);
 		if(v!=val)
 		{
-			throw Exception(ctx,info,"%d read %d required",v,val);
+			ctx->fail(info,ERR_VALUE,"%d read %d required",v,val);
 		}
 	}
 	else
@@ -374,7 +794,7 @@ void iox::uint_req(int bitsize,uint16_t val,const iox_info* info)
 		v=as_ix().uint16(bitsize,info);
 		if(v!=val)
 		{
-			throw Exception(ctx,info,"%d read %d required",v,val);
+			ctx->fail(info,ERR_VALUE,"%d read %d required",v,val);
 		}
 	}
 	else
@@ -390,7 +810,23 @@ void iox::uint_req(int bitsize,uint32_t val,const iox_info* info)
 		v=as_ix().uint32(bitsize,info);
 		if(v!=val)
 		{
-			throw Exception(ctx,info,"%d read %d required",v,val);
+			ctx->fail(info,ERR_VALUE,"%d read %d required",v,val);
+		}
+	}
+	else
+	{
+		as_ox().uint(bitsize,val,info);
+	}
+}
+void iox::uint_req(int bitsize,uint64_t val,const iox_info* info)
+{
+	if(ctx->is_parsing())
+	{
+		uint64_t v;
+		v=as_ix().uint64(bitsize,info);
+		if(v!=val)
+		{
+			ctx->fail(info,ERR_VALUE,"%llu read %llu required",(unsigned long long)v,(unsigned long long)val);
 		}
 	}
 	else
@@ -469,25 +905,26 @@ uint32_t ix::uint32(int bitsize, const iox_info* info)
 	else
 		return as_icx().uint(bitsize,info);
 }
+uint64_t ix::uint64(int bitsize, const iox_info* info)
+{
+	if(ctx->is_binary())
+		return as_ibx().uint64(bitsize,info);
+	else
+		return as_icx().uint64(bitsize,info);
+}
 void ix::named_block_begin(int bitsize,const iox_info* info)
 {
 	if(ctx->is_binary())
-	{
-		uint32_t length=as_ibx().uint32(bitsize,info);
-		as_ibx().block_begin(length,info);
-	}
+		as_ibx().named_block_begin(bitsize,info);
 	else
-	{
-		uint32_t length=as_icx().uint(bitsize,info);
-		as_icx().block_begin(length,info);
-	}
+		as_icx().named_block_begin(bitsize,info);
 }
 uint32_t ix::named_block_end(const iox_info* info)
 {
 	if(ctx->is_binary())
-		return as_ibx().block_end(info);
+		return as_ibx().named_block_end(info);
 	else
-		return as_icx().block_end(info);
+		return as_icx().named_block_end(info);
 }
 uint32_t ix::block_size_left()
 {
@@ -513,73 +950,64 @@ ocx ox::as_ocx()
 {
 	return ocx((ocCtx*)ctx);
 }
+omx ox::as_omx()
+{
+	return omx((obCtx*)ctx);
+}
 void ox::uint(int bitsize, uint8_t val, const iox_info* info)
 {
-	if(ctx->is_binary())
+	if(ctx->is_measuring())
+		as_omx().uint(bitsize,val,info);
+	else if(ctx->is_binary())
 		as_obx().uint(bitsize,val,info);
 	else
 		as_ocx().uint(bitsize,val,info);
 }
 void ox::uint(int bitsize, uint16_t val, const iox_info* info)
 {
-	if(ctx->is_binary())
+	if(ctx->is_measuring())
+		as_omx().uint(bitsize,val,info);
+	else if(ctx->is_binary())
 		as_obx().uint(bitsize,val,info);
 	else
 		as_ocx().uint(bitsize,val,info);
 }
 void ox::uint(int bitsize, uint32_t val, const iox_info* info)
 {
-	if(ctx->is_binary())
+	if(ctx->is_measuring())
+		as_omx().uint(bitsize,val,info);
+	else if(ctx->is_binary())
+		as_obx().uint(bitsize,val,info);
+	else
+		as_ocx().uint(bitsize,val,info);
+}
+void ox::uint(int bitsize, uint64_t val, const iox_info* info)
+{
+	if(ctx->is_measuring())
+		as_omx().uint(bitsize,val,info);
+	else if(ctx->is_binary())
 		as_obx().uint(bitsize,val,info);
 	else
 		as_ocx().uint(bitsize,val,info);
 }
 void ox::named_block_begin(int bitsize,const iox_info* info)
 {
-	if(ctx->is_binary())
-	{
-		uint32_t pos=ctx->bitpos;
-		ctx->bitpos+=bitsize;
-		as_obx().block_begin((1<<bitsize)-1,info);
-		as_obx().ctx->scope_stack.back().position_for_write=pos;
-	}
+	if(ctx->is_measuring())
+		as_omx().named_block_begin(bitsize,info);
+	else if(ctx->is_binary())
+		as_obx().named_block_begin(bitsize,info);
 	else
-	{
-		uint32_t pos=as_ocx().ctx->prod.size();
-		ctx->bitpos+=bitsize;
-		as_ocx().block_begin((1<<bitsize)-1,info);//size { }
-		as_ocx().ctx->scope_stack.back().position_for_write=pos;
-	}
+		as_ocx().named_block_begin(bitsize,info);
 }
-
 uint32_t ox::named_block_end(const iox_info* info)
 {
-	uint32_t block_length;
-	if(ctx->is_binary())
-	{
-		obx x=as_obx();
-		obScope s=x.ctx->scope_stack.back();
-		block_length=x.block_end(info);
-		uint32_t temp_pos=ctx->bitpos;
-		int bitsize=s.bitpos_at_enter-s.position_for_write;
-		ctx->bitpos=s.position_for_write;
-		x.uint(bitsize,block_length,info);
-		ctx->bitpos=temp_pos;
-	}
+	if(ctx->is_measuring())
+		return as_omx().named_block_end(info);
+	else if(ctx->is_binary())
+		return as_obx().named_block_end(info);
 	else
-	{
-		ocx x=as_ocx();
-		ocScope s=x.ctx->scope_stack.back();
-		block_length=x.block_end(info);
-		std::string tail=x.ctx->prod.substr(s.position_for_write);
-		x.ctx->prod.resize(s.position_for_write);
-		//x.uint(32,block_length,s.info);
-		x.ctx->write_uint(32,block_length,s.info);
-		x.ctx->prod+=tail;
-	}
-	return block_length;
+		return as_ocx().named_block_end(info);
 }
-
 uint32_t ox::block_size_left()
 {
 	if(ctx->is_binary())
@@ -603,37 +1031,34 @@ uint32_t ox::block_size_left()
 
 
 
-ibx::ibx(ibCtx* x)
-{
-	ctx=x;
-}
-uint8_t ibx::uint8(int bitsize,const iox_info* info)
-{
-	int8_t val=0;
-	if(ctx->bitpos + bitsize > ctx->bitlimit) throw Exception(ctx,info,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
-	val=ctx->nocheck_uint8(bitsize);
-	return val;
-}
-uint16_t ibx::uint16(int bitsize,const iox_info* info)
+void ibx::named_block_begin(int bitsize,const iox_info* info)
 {
-	int16_t val=0;
-	if(ctx->bitpos + bitsize > ctx->bitlimit) throw Exception(ctx,info,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
-	val=ctx->nocheck_uint16(bitsize);
-	return val;
+	uint32_t length=uint32(bitsize,info);
+	block_begin(length,info);
 }
-uint32_t ibx::uint32(int bitsize,const iox_info* info)
+uint32_t ibx::named_block_end(const iox_info* info)
 {
-	int32_t val=0;
-	if(ctx->bitpos + bitsize > ctx->bitlimit) throw Exception(ctx,info,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
-	val=ctx->nocheck_uint32(bitsize);
-	return val;
+	return block_end(info);
 }
 void ibx::block_begin(int block_length,const iox_info* info)
 {
+	if(ctx->failed)
+		return;
+	if(ctx->scope_stack.full())
+	{
+		ctx->fail(info,ERR_BLOCK,"blocks nested deeper then %d",ctx->scope_stack.max_size());
+		return;
+	}
 	if((ctx->bitpos&7) != 0 )
-		throw Exception(ctx,info,"starting bit not byte-aligned");
+	{
+		ctx->fail(info,ERR_ALIGNMENT,"starting bit not byte-aligned");
+		return;
+	}
 	if(ctx->bitpos + block_length*8 > ctx->bitlimit)
-		throw Exception(ctx,info,"block size %d exceeds available %d",block_length*8,ctx->bitlimit-ctx->bitpos);
+	{
+		ctx->fail(info,ERR_NO_SPACE,"block size %d exceeds available %d",block_length*8,ctx->bitlimit-ctx->bitpos);
+		return;
+	}
 
 	ibScope s;
 	s.bitlimit_at_enter=ctx->bitlimit;
@@ -644,58 +1069,56 @@ void ibx::block_begin(int block_length,const iox_info* info)
 }
 uint32_t ibx::block_end(const iox_info* info)
 {
-	if(ctx->scope_stack.size()==0) throw Exception(ctx,info,"unmatched named_block_end");
+	if(ctx->failed)
+		return 0;
+	if(ctx->scope_stack.size()==0)
+	{
+		ctx->fail(info,ERR_BLOCK,"unmatched named_block_end");
+		return 0;
+	}
 	ibScope &s=ctx->scope_stack.back();
 	if(ctx->bitpos<ctx->bitlimit)
-		throw Exception(ctx,info,"block ends with %d bits remaining",ctx->bitlimit-ctx->bitpos);
+	{
+		ctx->fail(info,ERR_BLOCK,"block ends with %d bits remaining",ctx->bitlimit-ctx->bitpos);
+		return 0;
+	}
 	uint32_t len=ctx->bitpos-s.bitpos_at_enter;
 	if((len&7) != 0 )
-		throw Exception(ctx,info,"block length not byte-aligned");
+	{
+		ctx->fail(info,ERR_ALIGNMENT,"block length not byte-aligned");
+		return 0;
+	}
 	ctx->bitlimit=s.bitlimit_at_enter;
 	ctx->scope_stack.pop_back();
 	return len/8;
 }
-uint32_t ibx::block_size_left()
+void obx::named_block_begin(int bitsize,const iox_info* info)
 {
-	return ctx->bitlimit - ctx->bitpos;
-}
-
-
-
-
-obx::obx(obCtx* x)
-{
-	ctx=x;
-}
-void obx::uint(int bitsize,uint8_t val,const iox_info* info)
-{
-	if(ctx->bitpos + bitsize > ctx->bitlimit)
-		throw Exception(ctx,info,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
-	ctx->nocheck_uint(bitsize,val);
-}
-void obx::uint(int bitsize,uint16_t val,const iox_info* info)
-{
-	if(ctx->bitpos + bitsize > ctx->bitlimit)
-		throw Exception(ctx,info,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
-	ctx->nocheck_uint(bitsize,val);
-}
-void obx::uint(int bitsize,uint32_t val,const iox_info* info)
-{
-	if(ctx->bitpos + bitsize > ctx->bitlimit)
-		throw Exception(ctx,info,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
-
-	if((ctx->bitpos&7) + bitsize<=32)
-	{
-		ctx->nocheck_uint(bitsize,val);
-	}
-	else
-		throw Exception(ctx,info,"value spans over 5 bytes");
+	uint32_t pos=ctx->bitpos;
+	ctx->bitpos+=bitsize;
+	ctx->advance();
+	block_begin((1<<bitsize)-1,info);
+	ctx->scope_stack.back().position_for_write=pos;
+}
+uint32_t obx::named_block_end(const iox_info* info)
+{
+	obScope s=ctx->scope_stack.back();
+	uint32_t block_length=block_end(info);
+	ctx->advance();
+	uint32_t temp_pos=ctx->bitpos;
+	int bitsize=s.bitpos_at_enter-s.position_for_write;
+	ctx->bitpos=s.position_for_write;
+	uint(bitsize,block_length,info);
+	ctx->bitpos=temp_pos;
+	return block_length;
 }
 void obx::block_begin(uint32_t block_size_limit,const iox_info* info)
 {
+	if(ctx->scope_stack.full())
+		throw Exception(ctx,info,ERR_BLOCK,"blocks nested deeper then %d",ctx->scope_stack.max_size());
 	block_size_limit=block_size_limit*8;
 	if((ctx->bitpos&7) != 0 )
-		throw Exception(ctx,info,"starting bit not byte-aligned");
+		throw Exception(ctx,info,ERR_ALIGNMENT,"starting bit not byte-aligned");
 	if(ctx->bitpos + block_size_limit > ctx->bitlimit)
 		block_size_limit=ctx->bitlimit-ctx->bitpos;
 
@@ -709,41 +1132,113 @@ void obx::block_begin(uint32_t block_size_limit,const iox_info* info)
 
 uint32_t obx::block_end(const iox_info* info)
 {
-	if(ctx->scope_stack.size()==0) throw Exception(ctx,info,"unmatched named_block_end");
+	if(ctx->scope_stack.size()==0) throw Exception(ctx,info,ERR_BLOCK,"unmatched named_block_end");
 	obScope &s=ctx->scope_stack.back();
 	uint32_t len=ctx->bitpos-s.bitpos_at_enter;
 	if((len&7) != 0 )
-		throw Exception(ctx,info,"block length not byte-aligned");
+		throw Exception(ctx,info,ERR_ALIGNMENT,"block length not byte-aligned");
 	ctx->bitlimit=s.bitlimit_at_enter;
 	ctx->scope_stack.pop_back();
 	return len/8;
 }
-uint32_t obx::block_size_left()
+void omx::named_block_begin(int bitsize,const iox_info* info)
 {
-	return ctx->bitlimit - ctx->bitpos;
+	uint(bitsize,0,info);
+	block_begin((1<<bitsize)-1,info);
 }
-
-
-
-
-
-
-icx::icx(icCtx* x)
+uint32_t omx::named_block_end(const iox_info* info)
 {
-	ctx=x;
+	return block_end(info);
 }
+void ipx::named_block_begin(int bitsize,const iox_info* info)
+{
+	if(skipping)
+	{
+		skipping++;
+		return;
+	}
+	if(ctx->scope_stack.size()<keep_depth)
+	{
+		ibx(ctx).named_block_begin(bitsize,info);
+		return;
+	}
+	uint32_t length=ibx(ctx).uint32(bitsize,info);
+	if(ctx->failed)
+		return;
+	if((ctx->bitpos&7) != 0 )
+	{
+		ctx->fail(info,ERR_ALIGNMENT,"starting bit not byte-aligned");
+		return;
+	}
+	if(ctx->bitpos + length*8 > ctx->bitlimit)
+	{
+		ctx->fail(info,ERR_NO_SPACE,"block size %d exceeds available %d",length*8,ctx->bitlimit-ctx->bitpos);
+		return;
+	}
+	ctx->bitpos+=length*8;
+	skipped_length=length;
+	skipping=1;
+}
+uint32_t ipx::named_block_end(const iox_info* info)
+{
+	if(skipping)
+	{
+		skipping--;
+		return skipping==0?skipped_length:0;
+	}
+	return ibx(ctx).named_block_end(info);
+}
+
 uint32_t icx::uint(int bitsize,  const iox_info* info)
 {
+	if(ctx->failed)
+		return 0;
 	uint32_t value=ctx->read_uint(bitsize,info);
 	ctx->bitpos+=bitsize;
 	return value;
 }
+uint64_t icx::uint64(int bitsize,  const iox_info* info)
+{
+	if(ctx->failed)
+		return 0;
+	uint64_t value=ctx->read_uint(bitsize,info);
+	ctx->bitpos+=bitsize;
+	return value;
+}
+void icx::uint_req(int bitsize,uint64_t val,const iox_info* info)
+{
+	uint64_t v=uint64(bitsize,info);
+	if(v!=val)
+		ctx->fail(info,ERR_VALUE,"%llu read %llu required",(unsigned long long)v,(unsigned long long)val);
+}
+void icx::named_block_begin(int bitsize,const iox_info* info)
+{
+	uint32_t length=uint(bitsize,info);
+	block_begin(length,info);
+}
+uint32_t icx::named_block_end(const iox_info* info)
+{
+	return block_end(info);
+}
 void icx::block_begin(int block_length,const iox_info* info)
 {
+	if(ctx->failed)
+		return;
+	if(ctx->scope_stack.full())
+	{
+		ctx->fail(info,ERR_BLOCK,"blocks nested deeper then %d",ctx->scope_stack.max_size());
+		return;
+	}
 	if((ctx->bitpos&7) != 0 )
-		throw Exception(ctx,info,"starting bit not byte-aligned");
+	{
+		ctx->fail(info,ERR_ALIGNMENT,"starting bit not byte-aligned");
+		return;
+	}
 	if(ctx->bitpos + block_length*8 > ctx->bitlimit)
-		throw Exception(ctx,info,"block size %d exceeds available %d",block_length*8,ctx->bitlimit-ctx->bitpos);
+	{
+		ctx->fail(info,ERR_NO_SPACE,"block size %d exceeds available %d",block_length*8,ctx->bitlimit-ctx->bitpos);
+		return;
+	}
 	ctx->enter_scope(info);
 	icScope s;
 	s.bitlimit_at_enter=ctx->bitlimit;
@@ -754,41 +1249,63 @@ void icx::block_begin(int block_length,const iox_info* info)
 }
 uint32_t icx::block_end(const iox_info* info)
 {
-	if(ctx->scope_stack.size()==0) throw Exception(ctx,info,"unmatched named_block_end");
+	if(ctx->failed)
+		return 0;
+	if(ctx->scope_stack.size()==0)
+	{
+		ctx->fail(info,ERR_BLOCK,"unmatched named_block_end");
+		return 0;
+	}
 	ctx->leave_scope(info);
 	icScope &s=ctx->scope_stack.back();
 	uint32_t len=ctx->bitpos-s.bitpos_at_enter;
 	if((len&7) != 0 )
-		throw Exception(ctx,info,"block length not byte-aligned");
+	{
+		ctx->fail(info,ERR_ALIGNMENT,"block length not byte-aligned");
+		return 0;
+	}
 	ctx->bitlimit=s.bitlimit_at_enter;
 	ctx->scope_stack.pop_back();
 	return len/8;
 }
 uint32_t icx::block_size_left()
 {
+	if(ctx->failed) return 0;
 	if(!ctx->skiptotoken()) return 0;
-	if(*ctx->parse_pos=='}') return 0;
+	if(ctx->peek()=='}') return 0;
 	return ctx->bitlimit - ctx->bitpos;
 }
 
 
-ocx::ocx(ocCtx* x)
-{
-	ctx=x;
-}
-void ocx::uint(int bitsize, uint32_t val, const iox_info* info)
+void ocx::uint(int bitsize, uint64_t val, const iox_info* info)
 {
 	if(ctx->bitpos+bitsize > ctx->bitlimit)
-		throw Exception(ctx,info,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
+		throw Exception(ctx,info,ERR_NO_SPACE,"left %d bits, needed %d",ctx->bitlimit-ctx->bitpos, bitsize);
 	ctx->write_uint(bitsize,val,info);
 	ctx->bitpos+=bitsize;
 }
 
+void ocx::named_block_begin(int bitsize,const iox_info* info)
+{
+	uint32_t pos=ctx->text_size();
+	ctx->bitpos+=bitsize;
+	block_begin((1<<bitsize)-1,info);//size { }
+	ctx->scope_stack.back().position_for_write=pos;
+}
+uint32_t ocx::named_block_end(const iox_info* info)
+{
+	ocScope& s=ctx->scope_stack.back();
+	//length goes before block, it is inserted when outermost block ends
+	ctx->insert_uint(s.position_for_write,ctx->scope_stack.size()-1,32,(ctx->bitpos-s.bitpos_at_enter)/8,s.info);
+	return block_end(info);
+}
 void ocx::block_begin(int block_size_limit,const iox_info* info)
 {
+	if(ctx->scope_stack.full())
+		throw Exception(ctx,info,ERR_BLOCK,"blocks nested deeper then %d",ctx->scope_stack.max_size());
 	block_size_limit*=8;
 	if((ctx->bitpos&7) != 0 )
-		throw Exception(ctx,info,"block begin is not byte-aligned");
+		throw Exception(ctx,info,ERR_ALIGNMENT,"block begin is not byte-aligned");
 	if(ctx->bitpos + block_size_limit > ctx->bitlimit)
 		block_size_limit=ctx->bitlimit-ctx->bitpos;
 
@@ -805,132 +1322,212 @@ uint32_t ocx::block_end(const iox_info* info)
 {
 	uint32_t block_length=ctx->bitpos-ctx->scope_stack.back().bitpos_at_enter;
 	if((block_length&7) != 0 )
-		throw Exception(ctx,info,"block length not byte-aligned");
+		throw Exception(ctx,info,ERR_ALIGNMENT,"block length not byte-aligned");
 	ctx->bitlimit=ctx->scope_stack.back().bitlimit_at_enter;
 	ctx->scope_stack.pop_back();
 	ctx->leave_scope(info);
+	if(ctx->scope_stack.size()==0)
+	{
+		ctx->merge_insertions();
+		//streamed output has no use for position outside blocks
+		if(ctx->sink!=NULL)
+			ctx->bitpos&=7;
+		ctx->chunk_done();
+	}
 	return block_length/8;
 }
-uint32_t ocx::block_size_left()
+/**
+ * Copies innermost blocks of scope stack to error record, innermost first.
+ */
+template<class S>
+static void snapshot_scopes(io_error& e,const S& stack)
 {
-	return ctx->bitlimit - ctx->bitpos;
+	e.depth=stack.size();
+	uint32_t n=e.depth<MOPA_ERROR_SCOPES?e.depth:MOPA_ERROR_SCOPES;
+	for(uint32_t i=0;i<n;i++)
+	{
+		const auto& s=stack[e.depth-1-i];
+		e.scopes[i].info=s.info;
+		e.scopes[i].bitpos_at_enter=s.bitpos_at_enter;
+		e.scopes[i].bitlimit_at_enter=s.bitlimit_at_enter;
+	}
+}
+/**
+ * Skips flags, width, precision and length of conversion that follows '%'.
+ * \param longs - receives number of 'l' length modifiers
+ * \return pointer to conversion character
+ */
+static const char* conversion_char(const char* f,int& longs)
+{
+	longs=0;
+	while(*f!=0 && strchr("-+ #0123456789.",*f)!=NULL) f++;
+	while(*f=='h') f++;
+	while(*f=='l') {longs++;f++;}
+	return f;
+}
+void io_error::record(const ioCtx* x, const iox_info* at, error_code c, const char* format, va_list ap)
+{
+	code=c;
+	info=at;
+	bitpos=x->bitpos;
+	bitlimit=x->bitlimit;
+	parsing=x->is_parsing();
+	binary=x->is_binary();
+	line=0;
+	column=0;
+	fmt=format;
+	nargs=0;
+	//only take arguments, formatting is left to io_error::message
+	for(const char* f=fmt;*f!=0;f++)
+	{
+		if(*f!='%') continue;
+		int longs;
+		f=conversion_char(f+1,longs);
+		if(*f==0 || nargs==MOPA_ERROR_ARGS) break;
+		if(*f=='%') continue;
+		arg& a=args[nargs++];
+		if(*f=='s')
+			a.s=va_arg(ap,const char*);
+		else if(longs>=2)
+			a.u=va_arg(ap,unsigned long long);
+		else if(longs==1)
+			a.u=va_arg(ap,unsigned long);
+		else
+			a.u=va_arg(ap,unsigned int);
+	}
+	if(x->is_parsing())
+		if(x->is_binary())
+			snapshot_scopes(*this,((const ibCtx*)x)->scope_stack);
+		else
+		{
+			const icCtx* y=(const icCtx*)x;
+			snapshot_scopes(*this,y->scope_stack);
+			line=y->line_nr;
+			column=y->parse_pos-y->line_begin;
+		}
+	else
+		if(x->is_binary())
+			snapshot_scopes(*this,((const obCtx*)x)->scope_stack);
+		else
+			snapshot_scopes(*this,((const ocCtx*)x)->scope_stack);
+}
+void Exception::record(const ioCtx* x, const iox_info* info, error_code code, const char* fmt, va_list args)
+{
+	error.record(x,info,code,fmt,args);
+	if(!x->nothrow)
+		message=error.message();
 }
-
 Exception::Exception(
 			const ioCtx* x,
-			const iox_info* _info,
+			const iox_info* info,
+			error_code code,
 			const char* fmt, ...)
+{
+	va_list argList;
+	va_start(argList, fmt);
+	record(x,info,code,fmt,argList);
+	va_end(argList);
+}
+Exception::Exception(
+			const ioCtx* x,
+			const iox_info* info,
+			const char* fmt, ...)
+{
+	va_list argList;
+	va_start(argList, fmt);
+	record(x,info,ERR_OTHER,fmt,argList);
+	va_end(argList);
+}
+Exception::Exception(const io_error& error):message(error.message()),error(error)
+{
+}
+void ioCtx::fail(const iox_info* info, error_code code, const char* fmt, ...)
+{
+	if(nothrow && failed)
+		return;
+	va_list argList;
+	va_start(argList, fmt);
+	if(nothrow)
 	{
-		static const iox_info empty_info={"-unknown-",0,"-unknown-",0};
-		va_list argList;
-		va_start(argList, fmt);
-		char* p=NULL;
-		int rr;
-		rr=vasprintf(&p, fmt, argList);
+		error.record(this,info,code,fmt,argList);
 		va_end(argList);
-		if(rr>0){message=p;free(p);}
-
-		const iox_info* info=_info;
-		if(info==NULL) info=&empty_info;
-		if(x->is_parsing())
+		failed=true;
+		return;
+	}
+	io_error e;
+	e.record(this,info,code,fmt,argList);
+	va_end(argList);
+	throw Exception(e);
+}
+std::string io_error::message() const
+{
+	static const iox_info empty_info={"-unknown-",0,"-unknown-",0};
+	std::string message;
+	char* p=NULL;
+	int rr;
+	uint32_t k=0;
+	for(const char* f=fmt==NULL?"":fmt;*f!=0;)
+	{
+		if(*f!='%')
 		{
-			if(x->is_binary())
-			{
-				ibCtx* y=(ibCtx*)x;
-				p=NULL;
-				rr=asprintf(&p," when parsing '%s' position %d.%d limit %d.%d declared in (%s:%d)",
-						info->name,y->bitpos/8,y->bitpos%8,y->bitlimit/8,y->bitlimit%8,
-						info->file==NULL?"":info->file,info->line);
-				if(rr>0){message+=p;free(p);}
-				for(int i=y->scope_stack.size()-1;i>=0;i--)
-				{
-					p=NULL;
-					ibScope& s=y->scope_stack[i];
-					info=s.info;
-					if(info==NULL) info=&empty_info;
-					rr=asprintf(&p,"\nin block '%s' position %d.%d limit %d.%d declared in (%s:%d)",
-							info->name,s.bitpos_at_enter/8,s.bitpos_at_enter%8,s.bitlimit_at_enter/8,s.bitlimit_at_enter%8,
-							info->file==NULL?"":info->file,info->line);
-					if(rr>0){message+=p;free(p);}
-				}
-			}
-			else
-			{
-				icCtx* y=(icCtx*)x;
-				const char* line_begin=y->parsed_text;
-				uint32_t line_nr=1;
-				const char* r;
-				for(r=y->parsed_text;r<y->parse_pos;r++)
-				{
-					if(*r=='\n')
-					{
-						line_begin=r+1;
-						line_nr++;
-					}
-				}
-				p=NULL;
-				rr=asprintf(&p," at <input>:%d:%ld when parsing '%s' position %d.%d limit %d.%d declared in (%s:%d)",
-						line_nr,r-line_begin,
-						info->name,y->bitpos/8,y->bitpos%8,y->bitlimit/8,y->bitlimit%8,
-						info->file==NULL?"":info->file,info->line);
-				if(rr>0){message+=p;free(p);}
-				for(int i=y->scope_stack.size()-1;i>=0;i--)
-				{
-					p=NULL;
-					icScope& s=y->scope_stack[i];
-					info=s.info;
-					if(info==NULL) info=&empty_info;
-					rr=asprintf(&p,"\nin block '%s' position %d.%d limit %d.%d declared in (%s:%d)",
-							info->name,s.bitpos_at_enter/8,s.bitpos_at_enter%8,s.bitlimit_at_enter/8,s.bitlimit_at_enter%8,
-							info->file==NULL?"":info->file,info->line);
-					if(rr>0){message+=p;free(p);}
-				}
-			}
+			const char* e=strchrnul(f,'%');
+			message.append(f,e-f);
+			f=e;
+			continue;
 		}
+		int longs;
+		const char* c=conversion_char(f+1,longs);
+		if(*c==0) break;
+		std::string spec(f,c+1-f);
+		f=c+1;
+		if(*c=='%') {message+='%';continue;}
+		if(k==nargs) break;
+		const arg& a=args[k++];
+		p=NULL;
+		if(*c=='s')
+			rr=asprintf(&p,spec.c_str(),a.s);
+		else if(longs>=2)
+			rr=asprintf(&p,spec.c_str(),(unsigned long long)a.u);
+		else if(longs==1)
+			rr=asprintf(&p,spec.c_str(),(unsigned long)a.u);
 		else
-		{
-			if(x->is_binary())
-			{
-				obCtx* y=(obCtx*)x;
-				p=NULL;
-				rr=asprintf(&p," when building '%s' position %d.%d limit %d.%d declared in (%s:%d)",
-						info->name,y->bitpos/8,y->bitpos%8,y->bitlimit/8,y->bitlimit%8,
-						info->file==NULL?"":info->file,info->line);
-				if(rr>0){message+=p;free(p);}
-				for(int i=y->scope_stack.size()-1;i>=0;i--)
-				{
-					p=NULL;
-					obScope& s=y->scope_stack[i];
-					info=s.info;
-					if(info==NULL) info=&empty_info;
-					rr=asprintf(&p,"\nin block '%s' position %d.%d limit %d.%d declared in (%s:%d)",
-							info->name,s.bitpos_at_enter/8,s.bitpos_at_enter%8,s.bitlimit_at_enter/8,s.bitlimit_at_enter%8,
-							info->file==NULL?"":info->file,info->line);
-					if(rr>0){message+=p;free(p);}
-				}
-			}
-			else
-			{
-				ocCtx* y=(ocCtx*)x;
-				p=NULL;
-				rr=asprintf(&p," when building '%s' position %d.%d limit %d.%d declared in (%s:%d)",
-						info->name,y->bitpos/8,y->bitpos%8,y->bitlimit/8,y->bitlimit%8,
-						info->file==NULL?"":info->file,info->line);
-				if(rr>0){message+=p;free(p);}
-				for(int i=y->scope_stack.size()-1;i>=0;i--)
-				{
-					p=NULL;
-					ocScope& s=y->scope_stack[i];
-					info=s.info;
-					if(info==NULL) info=&empty_info;
-					rr=asprintf(&p,"\nin block '%s' position %d.%d limit %d.%d declared in (%s:%d)",
-							info->name,s.bitpos_at_enter/8,s.bitpos_at_enter%8,s.bitlimit_at_enter/8,s.bitlimit_at_enter%8,
-							info->file==NULL?"":info->file,info->line);
-					if(rr>0){message+=p;free(p);}
-				}
-			}
-		}
+			rr=asprintf(&p,spec.c_str(),(unsigned int)a.u);
+		if(rr>0){message+=p;free(p);}
 	}
+	const iox_info* i=info;
+	if(i==NULL) i=&empty_info;
+	p=NULL;
+	if(parsing && !binary)
+		rr=asprintf(&p," at <input>:%d:%d when parsing '%s' position %d.%d limit %d.%d declared in (%s:%d)",
+				line,column,
+				i->name,bitpos/8,bitpos%8,bitlimit/8,bitlimit%8,
+				i->file==NULL?"":i->file,i->line);
+	else
+		rr=asprintf(&p," when %s '%s' position %d.%d limit %d.%d declared in (%s:%d)",
+				parsing?"parsing":"building",
+				i->name,bitpos/8,bitpos%8,bitlimit/8,bitlimit%8,
+				i->file==NULL?"":i->file,i->line);
+	if(rr>0){message+=p;free(p);}
+	uint32_t n=depth<MOPA_ERROR_SCOPES?depth:MOPA_ERROR_SCOPES;
+	for(uint32_t j=0;j<n;j++)
+	{
+		p=NULL;
+		const scope& s=scopes[j];
+		i=s.info;
+		if(i==NULL) i=&empty_info;
+		rr=asprintf(&p,"\nin block '%s' position %d.%d limit %d.%d declared in (%s:%d)",
+				i->name,s.bitpos_at_enter/8,s.bitpos_at_enter%8,s.bitlimit_at_enter/8,s.bitlimit_at_enter%8,
+				i->file==NULL?"":i->file,i->line);
+		if(rr>0){message+=p;free(p);}
+	}
+	if(depth>n)
+	{
+		p=NULL;
+		rr=asprintf(&p,"\nin %d more blocks",depth-n);
+		if(rr>0){message+=p;free(p);}
+	}
+	return message;
+}
 
 
 
@@ -12,6 +12,7 @@
 
 //table merger
 #include "inc/merger.h"
+#include "inc/crc.h"
 
 
 /**
@@ -80,11 +81,19 @@ public:
 	psi_extractor_impl(size_t max_section_size);
 	~psi_extractor_impl();
 	void ts_packet(const uint8_t* p);
+	void ts_packets(const uint8_t* packets, size_t n, size_t stride);
 	void on_section_ready(void* ctx, section_ready callback);
+	void on_section_ready(void* ctx, section_ready_crc callback);
+	void set_crc_check(crc_check mode);
 private:
+	void crc_advance(const uint8_t* section, size_t len);
 	size_t		  max_section_size;
 	section_ready callback;
+	section_ready_crc callback_crc;
 	void*		  callback_ctx;
+	crc_check	  crc_mode;
+	uint32_t	  crc;
+	size_t		  crc_len; //bytes of current section included in crc
 	size_t 		  dvb_section_length;
 	enum {wait_start, wait_more} state;
 	uint8_t* 	  data;
@@ -115,7 +124,11 @@ psi_extractor_impl<max_dbg>::psi_extractor_impl(size_t max_section_size)
 	if(max_section_size>(1<<12)) max_section_size=1<<12;
 	this->max_section_size=max_section_size;
 	callback=NULL;
+	callback_crc=NULL;
 	callback_ctx=NULL;
+	crc_mode=crc_none;
+	crc=0xffffffff;
+	crc_len=0;
 	dvb_section_length=0;
 	state=wait_start;
 	data=new uint8_t[max_section_size+184]; //some additional size may be required for processing
@@ -128,20 +141,61 @@ template <int max_dbg>
 void psi_extractor_impl<max_dbg>::on_section_ready(void* ctx, section_ready callback)
 {
 	this->callback=callback;
+	this->callback_crc=NULL;
 	this->callback_ctx=ctx;
 }
 
+template <int max_dbg>
+void psi_extractor_impl<max_dbg>::on_section_ready(void* ctx, section_ready_crc callback)
+{
+	this->callback=NULL;
+	this->callback_crc=callback;
+	this->callback_ctx=ctx;
+}
+
+template <int max_dbg>
+void psi_extractor_impl<max_dbg>::set_crc_check(crc_check mode)
+{
+	crc_mode=mode;
+}
+
+/**
+ * Includes in crc bytes of section that arrived since last call.
+ */
+template <int max_dbg>
+inline void psi_extractor_impl<max_dbg>::crc_advance(const uint8_t* section, size_t len)
+{
+	if(crc_mode!=crc_none && len>crc_len)
+	{
+		crc=mopa::dvb_crc32_update(crc,section+crc_len,len-crc_len);
+		crc_len=len;
+	}
+}
+
 template <int max_dbg>
 psi_extractor_impl<max_dbg>::~psi_extractor_impl()
 {
 	delete[] data;
 }
 
+template <int max_dbg>
+void psi_extractor_impl<max_dbg>::ts_packets(const uint8_t* packets, size_t n, size_t stride)
+{
+	for(size_t i=0;i<n;i++)
+		psi_extractor_impl<max_dbg>::ts_packet(packets+i*stride);
+}
+
 template <int max_dbg>
 void psi_extractor_impl<max_dbg>::ts_packet(const uint8_t* p)
 {
 	int reminder=TS_PACKET_LEN;
 	if(DBG(5)) dbg("ts_packet %2.2x:%2.2x:%2.2x:%2.2x\n",p[0],p[1],p[2],p[3]);
+	if(p[0]!=0x47)
+	{
+		if(DBG(2)) dbg("sync byte %2.2x => reset\n",p[0]);
+		state=wait_start;
+		return;
+	}
 	int pusi=(p[1]>>6) & 1; //payload_unit_start_indicator
 	uint16_t pid=(p[1]<<8 | p[2]) & ((1<<13) - 1);
 	uint8_t afc=(p[3]>>4) & 3; //adaptation_field_control
@@ -159,6 +213,8 @@ void psi_extractor_impl<max_dbg>::ts_packet(const uint8_t* p)
 			goto end;
 		}
 		data_len=0;
+		crc=0xffffffff;
+		crc_len=0;
 		this->cc=cc;
 	}
 	else
@@ -228,7 +284,8 @@ void psi_extractor_impl<max_dbg>::ts_packet(const uint8_t* p)
 	{
 		//can't even retrieve length
 		//copy rest data to beginning of buffer
-		memcpy(data,sec_p,data_len);
+		crc_advance(sec_p,data_len);
+		memmove(data,sec_p,data_len);
 		if(DBG(5)) dbg("%d bytes left for next section\n",data_len);
 		state=wait_more;goto end;
 	}
@@ -242,13 +299,32 @@ void psi_extractor_impl<max_dbg>::ts_packet(const uint8_t* p)
 	}
 	if(data_len>=dvb_section_length)
 	{
-		if(callback==NULL)
+		if(callback==NULL && callback_crc==NULL)
 		{
 			if(DBG(1)) dbg("section callback not set\n");
 			state=wait_start;goto end;
 		}
 		if(DBG(3)) dbg("Section completed len=%d\n",dvb_section_length);
-		callback(callback_ctx, sec_p, dvb_section_length);
+		bool crc_ok=true;
+		if(crc_mode!=crc_none)
+		{
+			//CRC_32 is present when section_syntax_indicator is set, and in TOT
+			if((sec_p[1]&0x80) || sec_p[0]==0x73)
+			{
+				crc_advance(sec_p,dvb_section_length);
+				crc_ok=(crc==0);
+			}
+			crc=0xffffffff;
+			crc_len=0;
+		}
+		if(!crc_ok && crc_mode==crc_drop)
+		{
+			if(DBG(2)) dbg("CRC error, section dropped\n");
+		}
+		else if(callback_crc!=NULL)
+			callback_crc(callback_ctx, sec_p, dvb_section_length, crc_ok);
+		else
+			callback(callback_ctx, sec_p, dvb_section_length);
 		sec_p+=dvb_section_length;
 		data_len-=dvb_section_length;
 		if(DBG(5)) dbg("data_len=%d\n",data_len);
@@ -256,7 +332,8 @@ void psi_extractor_impl<max_dbg>::ts_packet(const uint8_t* p)
 			goto more_sections;
 		state=wait_start;goto end;
 	}
-	memcpy(data,sec_p,data_len);
+	crc_advance(sec_p,data_len);
+	memmove(data,sec_p,data_len);
 	if(DBG(5)) dbg("%d bytes left for next section\n",data_len);
 	state=wait_more;goto end;
 	end:;
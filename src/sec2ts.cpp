@@ -68,19 +68,28 @@ public:
 	virtual void flush();
 	virtual void on_adaptation_field(void* ctx, adaptation_field callback);
 	virtual void on_ts_packet_produced(void* ctx, ts_packet_produced callback);
+	virtual void on_ts_packets_produced(void* ctx, ts_packets_produced callback, size_t max_packets);
 	virtual void set_dbg_level(uint8_t level);
 	template<int DBG_LEVEL> void sectionX(const uint8_t* section, uint32_t size);
 
 	void inline fix_header(bool payload_unit_start,uint32_t adaptation_value);
+	void inline produce();
+	void use_packet_buffer(uint8_t* buffer);
 	uint16_t pid;
 	ts_packet_produced on_packet_produced_cb;
 	void* on_packet_produced_ctx;
+	ts_packets_produced on_packets_produced_cb;
+	void* on_packets_produced_ctx;
 	adaptation_field on_adaptation_field_cb;
 	void* on_adaptation_field_ctx;
 	void (sec2ts_impl::*section_impl)(const uint8_t* section, uint32_t size);
 	uint8_t dbg_level;
 	uint8_t cc;
-	uint8_t ts_packet[TS_PACKET_LEN];
+	uint8_t* ts_packet; //packet being filled, either single_packet or slot in batch
+	uint8_t single_packet[TS_PACKET_LEN];
+	uint8_t* batch;
+	size_t batch_size;
+	size_t batch_used;
 
 	//uint8_t adaptation_len;
 	bool pusi;
@@ -122,7 +131,7 @@ template<int DBG_LEVEL> void sec2ts_impl::sectionX(const uint8_t* section, uint3
 				//cannot add pointer field when only 1 byte remains
 				ts_packet[TS_PACKET_LEN-1]=0xff;
 				fix_header(false,payload_start>4?AFC_ADAPTATION_AND_PAYLOAD:AFC_PAYLOAD);
-				on_packet_produced_cb(on_packet_produced_ctx,ts_packet);
+				produce();
 				payload_start=0;
 				pusi=false;
 				cc=(cc+1)&0xf;
@@ -150,7 +159,7 @@ template<int DBG_LEVEL> void sec2ts_impl::sectionX(const uint8_t* section, uint3
 			section+=rem;
 			size-=rem;
 			fix_header(true,payload_start>4?AFC_ADAPTATION_AND_PAYLOAD:AFC_PAYLOAD);
-			on_packet_produced_cb(on_packet_produced_ctx,ts_packet);
+			produce();
 			payload_start=0;
 			pusi=false;
 			cc=(cc+1)&0xf;
@@ -171,7 +180,7 @@ template<int DBG_LEVEL> void sec2ts_impl::sectionX(const uint8_t* section, uint3
 	if(rem<=1)
 	{
 		fix_header(true,AFC_ADAPTATION);
-		on_packet_produced_cb(on_packet_produced_ctx,ts_packet);
+		produce();
 		payload_start=0;
 		pusi=false;
 		//no cc increment when no data
@@ -199,7 +208,7 @@ template<int DBG_LEVEL> void sec2ts_impl::sectionX(const uint8_t* section, uint3
 		section+=rem;
 		size-=rem;
 		fix_header(pusi,payload_start>4?AFC_ADAPTATION_AND_PAYLOAD:AFC_PAYLOAD);
-		on_packet_produced_cb(on_packet_produced_ctx,ts_packet);
+		produce();
 		payload_start=0;
 		pusi=false;
 		cc=(cc+1)&0xf;
@@ -213,19 +222,28 @@ sec2ts_impl::sec2ts_impl():
 		pid(0),
 		on_packet_produced_cb(NULL),
 		on_packet_produced_ctx(NULL),
+		on_packets_produced_cb(NULL),
+		on_packets_produced_ctx(NULL),
 		on_adaptation_field_cb(NULL),
 		on_adaptation_field_ctx(NULL),
 		dbg_level(0),
 		cc(0),
+		batch(NULL),
+		batch_size(0),
+		batch_used(0),
 		pusi(false),
 		payload_start(0),
 		payload_end(0)
 {
+	ts_packet=single_packet;
 	memset(ts_packet,0,TS_PACKET_LEN);
 	section_impl=&sec2ts_impl::sectionX<0>;
 };
 
-sec2ts_impl::~sec2ts_impl(){};
+sec2ts_impl::~sec2ts_impl()
+{
+	delete[] batch;
+};
 void inline sec2ts_impl::fix_header(bool payload_unit_start,uint32_t adaptation_value)
 {
 	ts_packet[0]=0x47;
@@ -233,6 +251,35 @@ void inline sec2ts_impl::fix_header(bool payload_unit_start,uint32_t adaptation_
 	ts_packet[2]=pid;
 	ts_packet[3]=(adaptation_value)<<4|cc;
 }
+/**
+ * Passes completed ts_packet on, and selects place for next one.
+ */
+void inline sec2ts_impl::produce()
+{
+	if(on_packets_produced_cb==NULL)
+	{
+		on_packet_produced_cb(on_packet_produced_ctx,ts_packet);
+		return;
+	}
+	batch_used++;
+	if(batch_used==batch_size)
+	{
+		on_packets_produced_cb(on_packets_produced_ctx,batch,batch_used);
+		batch_used=0;
+	}
+	ts_packet=batch+batch_used*TS_PACKET_LEN;
+}
+
+/**
+ * Moves packet being filled to \b buffer.
+ */
+void sec2ts_impl::use_packet_buffer(uint8_t* buffer)
+{
+	if(buffer!=ts_packet)
+		memcpy(buffer,ts_packet,TS_PACKET_LEN);
+	ts_packet=buffer;
+}
+
 void sec2ts_impl::setPID(uint16_t pid)
 {
 	this->pid=pid&((1<<13)-1);
@@ -248,11 +295,18 @@ void sec2ts_impl::flush()
 	{
 		fix_header(pusi,payload_start>4?AFC_ADAPTATION_AND_PAYLOAD:AFC_PAYLOAD);
 		memset(ts_packet+payload_end,0xff,TS_PACKET_LEN-payload_end);
-		on_packet_produced_cb(on_packet_produced_ctx,ts_packet);
+		produce();
 		payload_start=0;
 		pusi=false;
 		cc=(cc+1)&0xf;
 	}
+	if(on_packets_produced_cb!=NULL && batch_used!=0)
+	{
+		//no packet is being filled now
+		on_packets_produced_cb(on_packets_produced_ctx,batch,batch_used);
+		batch_used=0;
+		ts_packet=batch;
+	}
 }
 
 void sec2ts_impl::set_dbg_level(uint8_t level)
@@ -276,9 +330,31 @@ void sec2ts_impl::on_adaptation_field(void* ctx, adaptation_field callback)
 }
 void sec2ts_impl::on_ts_packet_produced(void* ctx, ts_packet_produced callback)
 {
+	if(on_packets_produced_cb!=NULL && batch_used!=0)
+		on_packets_produced_cb(on_packets_produced_ctx,batch,batch_used);
+	batch_used=0;
+	use_packet_buffer(single_packet);
+	on_packets_produced_cb=NULL;
+	on_packets_produced_ctx=NULL;
 	on_packet_produced_ctx=ctx;
 	on_packet_produced_cb=callback;
 }
+void sec2ts_impl::on_ts_packets_produced(void* ctx, ts_packets_produced callback, size_t max_packets)
+{
+	if(max_packets==0) max_packets=1;
+	if(on_packets_produced_cb!=NULL && batch_used!=0)
+		on_packets_produced_cb(on_packets_produced_ctx,batch,batch_used);
+	batch_used=0;
+	uint8_t* old_batch=batch;
+	batch=new uint8_t[max_packets*TS_PACKET_LEN];
+	batch_size=max_packets;
+	use_packet_buffer(batch);
+	delete[] old_batch;
+	on_packets_produced_ctx=ctx;
+	on_packets_produced_cb=callback;
+	on_packet_produced_cb=NULL;
+	on_packet_produced_ctx=NULL;
+}
 
 
 
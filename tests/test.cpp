@@ -1,6 +1,7 @@
 #include "inc/io.h"
 #include "inc/commontypes.h"
 #include "inc/descriptors.h"
+#include "inc/crc.h"
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -9,13 +10,14 @@
 #include <map>
 #include <string>
 #include <string.h>
+#include <time.h>
 
 #include "inc/merger.h"
+#include "inc/demux.h"
+#include "inc/framer.h"
+#include "inc/sec2ts.h"
 #include "dvb/NIT.h"
-namespace mopa
-{
-	uint32_t dvb_crc32(const uint8_t *data, int len);
-}
+#include "dvb/EIT.h"
 using namespace std;
 using namespace mopa;
 class Testbed
@@ -70,11 +72,13 @@ class Testbed
                int result;
                result=(*it).first();
                printf("result=%d\n",result);
+               return result;
             }
             else
             {
                printf("no such test\n");
             }
+            return 0;
          }
    private:
       int (*m_test)(void); //used to define dependencies for operator,
@@ -117,7 +121,6 @@ int test_parse_bits()
 {
 	const unsigned char byte[]={0xed};
 	iox x=iox::parse_binary(byte,1);
-	uint8_t vv;
 	int i;
 	uint8_t v[8];
 	for(i=0;i<8;i++)
@@ -306,15 +309,42 @@ int test_parse_uint32_t_extensive()
 	return 0;
 }
 
+DEFTEST(test_parse_mixed_widths,"parse long sequence of mixed-width fields up to end of data");
+MAKEDEP(test_parse_mixed_widths,test_parse_uint32_t_extensive);
+int test_parse_mixed_widths()
+{
+	uint8_t bytes[61];
+	for(size_t i=0;i<sizeof(bytes);i++)
+		bytes[i]=(i*167+13)^(i>>2);
+	for(int start=0;start<40;start++)
+	{
+		iox x=iox::parse_binary(bytes,sizeof(bytes));
+		uint32_t pos=0;
+		int width=start%32+1;
+		while(pos+width<=sizeof(bytes)*8)
+		{
+			uint32_t expected=0;
+			for(int b=0;b<width;b++)
+				expected=(expected<<1)|((bytes[(pos+b)/8]>>(7-(pos+b)%8))&1);
+			uint32_t v;
+			x.uint(width,v);
+			if(v!=expected) return -(start*1000+width);
+			pos+=width;
+			width=(width*7+start)%32+1;
+		}
+		if(x.ctx->bitpos!=pos) return -100000-start;
+	}
+	return 0;
+}
+
 //%d (%s:%d) parsing '%s'
 void parseExceptionMsg(const std::string msg,std::string& file,uint32_t& line,std::string& name)
 {
-	size_t a,b,c,d,e;
+	size_t a,b,d,e;
 	d=msg.find('\'');
 	e=msg.find('\'',d+1);
 	a=msg.find('(',e);
 	b=msg.find(':',a);
-	c=msg.find(')',b);
 
 	file=msg.substr(a+1,b-a-1);
 	line=atoi(msg.substr(b+1).c_str());
@@ -512,6 +542,315 @@ int test_basic_construct_uint32_t()
 
 
 
+DEFTEST(test_construct_mixed_widths,"construct long sequence of mixed-width fields up to end of buffer");
+MAKEDEP(test_construct_mixed_widths,test_basic_construct_uint32_t);
+int test_construct_mixed_widths()
+{
+	for(int size=1;size<40;size++)
+	{
+		uint8_t data[40];
+		uint8_t expected[40]={0};
+		memset(data,0x5a,sizeof(data));
+		iox x=iox::construct_binary(data,size);
+		uint32_t pos=0;
+		int width=size%32+1;
+		while(pos+width<=(uint32_t)size*8)
+		{
+			uint32_t v=(pos*2654435761U)>>(32-width);
+			for(int b=0;b<width;b++)
+				if((v>>(width-1-b))&1)
+					expected[(pos+b)/8]|=0x80>>((pos+b)%8);
+			x.uint(width,v);
+			pos+=width;
+			width=(width*7+size)%32+1;
+		}
+		if(memcmp(data,expected,pos/8)!=0) return -size;
+		if(data[size]!=0x5a) return -1000-size;
+	}
+	return 0;
+}
+
+DEFTEST(test_construct_block_backpatch,"construct unaligned block length written after block content");
+MAKEDEP(test_construct_block_backpatch,test_construct_mixed_widths);
+int test_construct_block_backpatch()
+{
+	//1010 [000000000011] 11111111 00000001 00000010 0000
+	const unsigned char bytes[]={0xa0,0x03,0xff,0x01,0x02};
+	unsigned char data[5];
+	memset(data,0xee,sizeof(data));
+	iox x=iox::construct_binary(data,sizeof(data));
+	try
+	{
+		uint8_t a=0xa,b=0xff,c=1,d=2;
+		x.uint(4,DVB_VAR(a));
+		x.named_block_begin(12,DVB_INFO("length"));
+		x.uint(8,DVB_VAR(b));
+		x.uint(8,DVB_VAR(c));
+		x.uint(8,DVB_VAR(d));
+		if(x.named_block_end(DVB_INFO("length"))!=3) return -1;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -2;
+	}
+	if(memcmp(bytes,data,sizeof(bytes))!=0) return -3;
+	return 0;
+}
+
+DEFTEST(test_construct_block_memcpy_payload,"construct block which content is copied with memcpy only");
+MAKEDEP(test_construct_block_memcpy_payload,test_construct_block_backpatch);
+int test_construct_block_memcpy_payload()
+{
+	const unsigned char bytes[]={0x55,0x06,'a','b','c','d','e','f',0x77,0xee};
+	unsigned char data[10];
+	memset(data,0xee,sizeof(data));
+	iox x=iox::construct_binary(data,sizeof(data));
+	try
+	{
+		uint8_t a=0x55,b=0x77;
+		std::string str="abcdef";
+		x.uint(8,DVB_VAR(a));
+		x.named_block_begin(8,DVB_INFO("length"));
+		fixed_string_io(x,6,str,DVB_INFO("str"));
+		if(x.named_block_end(DVB_INFO("length"))!=6) return -1;
+		x.uint(8,DVB_VAR(b));
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -2;
+	}
+	if(memcmp(bytes,data,sizeof(bytes))!=0) return -3;
+	return 0;
+}
+
+DEFTEST(test_uint64_t_binary,"construct/parse uint64_t of various sizes and positions");
+MAKEDEP(test_uint64_t_binary,test_construct_mixed_widths,test_parse_mixed_widths);
+int test_uint64_t_binary()
+{
+	//MJD 0xc079, 12:45:00 BCD as in TDT UTC_time
+	const unsigned char tdt[]={0x70,0xc0,0x79,0x12,0x45,0x00};
+	iox t=iox::parse_binary(tdt,sizeof(tdt));
+	uint8_t table_id;
+	uint64_t UTC_time;
+	t.uint(8,DVB_VAR(table_id));
+	t.uint(40,DVB_VAR(UTC_time));
+	if(UTC_time!=0xc079124500ULL) return -1;
+
+	const int widths[]={33,40,64,1,57,58,7,63,32,41};
+	for(int pos=0;pos<8;pos++)
+	{
+		uint8_t data[64]={0};
+		iox x=iox::construct_binary(data,sizeof(data));
+		uint64_t v;
+		if(pos!=0)
+		{
+			v=0;
+			x.uint(pos,v);
+		}
+		for(int i=0;i<(int)(sizeof(widths)/sizeof(*widths));i++)
+		{
+			v=(0x9e3779b97f4a7c15ULL*(i+pos+1))>>(64-widths[i]);
+			x.uint(widths[i],v);
+		}
+		iox y=iox::parse_binary(data,sizeof(data));
+		if(pos!=0)
+		{
+			y.uint(pos,v);
+			if(v!=0) return -2;
+		}
+		for(int i=0;i<(int)(sizeof(widths)/sizeof(*widths));i++)
+		{
+			y.uint(widths[i],v);
+			if(v!=(0x9e3779b97f4a7c15ULL*(i+pos+1))>>(64-widths[i])) return -(pos*100+i+10);
+		}
+	}
+	return 0;
+}
+
+DEFTEST(test_uint64_t_text,"construct/parse uint64_t as text");
+MAKEDEP(test_uint64_t_text,test_uint64_t_binary);
+int test_uint64_t_text()
+{
+	iox x=iox::construct_text();
+	uint64_t a=0x1ffffffffULL,b=0xc079124500ULL,c=0xfedcba9876543210ULL;
+	try
+	{
+		x.uint(33,DVB_VAR(a));
+		x.uint(40,b,DVB_INFO_HINT("b",FORMAT_HINT_HEX));
+		x.uint(64,DVB_VAR(c));
+		iox y=iox::parse_text(x.as_ocx().ctx->prod.c_str());
+		a=b=c=0;
+		y.uint(33,DVB_VAR(a));
+		y.uint(40,b,DVB_INFO_HINT("b",FORMAT_HINT_HEX));
+		y.uint(64,DVB_VAR(c));
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -1;
+	}
+	if(a!=0x1ffffffffULL) return -2;
+	if(b!=0xc079124500ULL) return -3;
+	if(c!=0xfedcba9876543210ULL) return -4;
+	return 0;
+}
+
+DEFTEST(test_uint_fixed_width,"construct/parse fields declared with uint<BITS>");
+MAKEDEP(test_uint_fixed_width,test_uint64_t_text);
+int test_uint_fixed_width()
+{
+	uint8_t a=1,b=0x55;
+	uint16_t c=0xabc;
+	uint64_t d=0x1ffffffffULL,e=0x3ffffffffffffffULL,f=0xfedcba9876543210ULL;
+	uint8_t buf_t[32]={0};
+	uint8_t buf_r[32]={0};
+	try
+	{
+		iox x=iox::construct_binary(buf_t,sizeof(buf_t));
+		x.uint<1>(DVB_VAR(a));
+		x.uint<7>(DVB_VAR(b));
+		x.uint_req<3,5>(DVB_INFO("req"));
+		x.uint<12>(DVB_VAR(c));
+		x.uint<33>(DVB_VAR(d));
+		x.uint<58>(DVB_VAR(e));
+		x.uint<64>(DVB_VAR(f));
+		iox y=iox::construct_binary(buf_r,sizeof(buf_r));
+		y.uint(1,DVB_VAR(a));
+		y.uint(7,DVB_VAR(b));
+		y.uint_req(3,5,DVB_INFO("req"));
+		y.uint(12,DVB_VAR(c));
+		y.uint(33,DVB_VAR(d));
+		y.uint(58,DVB_VAR(e));
+		y.uint(64,DVB_VAR(f));
+		if(x.ctx->bitpos!=178) return -1;
+		if(memcmp(buf_t,buf_r,sizeof(buf_t))!=0) return -2;
+
+		iox z=iox::parse_binary(buf_t,sizeof(buf_t));
+		ibx zb=z.as_ibx();
+		a=b=0;c=0;d=e=f=0;
+		zb.uint<1>(DVB_VAR(a));
+		zb.uint<7>(DVB_VAR(b));
+		zb.uint_req<3,5>(DVB_INFO("req"));
+		zb.uint<12>(DVB_VAR(c));
+		zb.uint<33>(DVB_VAR(d));
+		zb.uint<58>(DVB_VAR(e));
+		zb.uint<64>(DVB_VAR(f));
+		if(a!=1 || b!=0x55 || c!=0xabc) return -3;
+		if(d!=0x1ffffffffULL || e!=0x3ffffffffffffffULL || f!=0xfedcba9876543210ULL) return -4;
+
+		iox t=iox::construct_text();
+		t.uint<12>(DVB_VAR(c));
+		t.uint<64>(DVB_VAR(f));
+		iox u=iox::parse_text(t.as_ocx().ctx->prod.c_str());
+		c=0;f=0;
+		u.uint<12>(DVB_VAR(c));
+		u.uint<64>(DVB_VAR(f));
+		if(c!=0xabc || f!=0xfedcba9876543210ULL) return -5;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -6;
+	}
+	try
+	{
+		iox x=iox::construct_binary(buf_t,sizeof(buf_t));
+		uint8_t v=16;
+		x.uint<4>(DVB_VAR(v));
+		return -7;
+	}
+	catch(const Exception& e)
+	{
+	}
+	try
+	{
+		iox z=iox::parse_binary(buf_t,sizeof(buf_t));
+		z.uint_req<8,0x56>(DVB_INFO("req"));
+		return -8;
+	}
+	catch(const Exception& e)
+	{
+	}
+	return 0;
+}
+
+DEFTEST(test_record_fields,"test fields of fixed-size record checked at once");
+MAKEDEP(test_record_fields,test_uint_fixed_width);
+int test_record_fields()
+{
+	uint16_t a=0x123;
+	uint8_t b=0x4;
+	uint32_t c=0x56789;
+	uint8_t buf[6]={0};
+	try
+	{
+		iox x=iox::construct_binary(buf,sizeof(buf));
+		obx xb=x.as_obx();
+		record<obx> r(xb,40,DVB_INFO("rec"));
+		r.uint<12>(DVB_VAR(a));
+		r.uint<4>(DVB_VAR(b));
+		r.uint_req<4,0xa>(DVB_INFO("req"));
+		r.uint<20>(DVB_VAR(c));
+		if(x.ctx->bitpos!=40) return -1;
+		if(buf[0]!=0x12 || buf[1]!=0x34 || buf[2]!=0xa5 || buf[3]!=0x67 || buf[4]!=0x89) return -2;
+
+		iox y=iox::parse_binary(buf,5);
+		ibx yb=y.as_ibx();
+		a=b=c=0;
+		record<ibx> q(yb,40,DVB_INFO("rec"));
+		q.uint<12>(DVB_VAR(a));
+		q.uint<4>(DVB_VAR(b));
+		q.uint_req<4,0xa>(DVB_INFO("req"));
+		q.uint<20>(DVB_VAR(c));
+		if(a!=0x123 || b!=0x4 || c!=0x56789) return -3;
+
+		iox t=iox::construct_text();
+		record<iox> p(t,40,DVB_INFO("rec"));
+		p.uint<12>(DVB_VAR(a));
+		p.uint<4>(DVB_VAR(b));
+		p.uint_req<4,0xa>(DVB_INFO("req"));
+		p.uint<20>(DVB_VAR(c));
+		iox u=iox::parse_text(t.as_ocx().ctx->prod.c_str());
+		a=b=c=0;
+		record<iox> o(u,40,DVB_INFO("rec"));
+		o.uint<12>(DVB_VAR(a));
+		o.uint<4>(DVB_VAR(b));
+		o.uint_req<4,0xa>(DVB_INFO("req"));
+		o.uint<20>(DVB_VAR(c));
+		if(a!=0x123 || b!=0x4 || c!=0x56789) return -4;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -5;
+	}
+	try
+	{
+		iox y=iox::parse_binary(buf,4);
+		ibx yb=y.as_ibx();
+		record<ibx> q(yb,40,DVB_INFO("rec"));
+		return -6;
+	}
+	catch(const Exception& e)
+	{
+	}
+	try
+	{
+		iox x=iox::construct_binary(buf,sizeof(buf));
+		obx xb=x.as_obx();
+		record<obx> r(xb,8,DVB_INFO("rec"));
+		b=0x10;
+		r.uint<4>(DVB_VAR(b));
+		return -7;
+	}
+	catch(const Exception& e)
+	{
+	}
+	return 0;
+}
+
 DEFTEST(test_block_parsing,"test simple block parsing");
 MAKEDEP(test_block_parsing,test_parse_uint8_t_extensive);
 int test_block_parsing()
@@ -519,9 +858,6 @@ int test_block_parsing()
 	const unsigned char bytes[]={0xab,0x01,0xcd,0xef,0x78};
 	iox x=iox::parse_binary(bytes,3);
 	uint8_t v;
-	uint8_t marker_v;
-	int marker;
-	int i;
 	try
 	{
 		x.uint(4,DVB_VAR(v));
@@ -553,9 +889,7 @@ int test_block_alignment_on_enter()
 	const unsigned char bytes[]={0xab,0x01,0xcd,0xef,0x78};
 
 	uint8_t v;
-	uint8_t marker_v;
 	int marker;
-	int i;
 
 	iox x=iox::parse_binary(bytes,5);
 	try
@@ -585,9 +919,7 @@ int test_block_alignment_on_exit()
 	const unsigned char bytes[]={0xab,0x01,0xcd,0xef,0x78};
 
 	uint8_t v;
-	uint8_t marker_v;
 	int marker;
-	int i;
 
 	iox x=iox::parse_binary(bytes,5);
 	try
@@ -705,7 +1037,7 @@ int test_construct_block_1()
 	iox x=iox::construct_text();
 	try
 	{
-		uint32_t a=1,b=2,c=3,d=4,e=5,f=6;
+		uint32_t a=1,c=3,d=4,e=5,f=6;
 		x.uint(6,DVB_VAR(a));
 		x.named_block_begin(2,DVB_INFO("b"));
 		x.uint(8,DVB_VAR(c));
@@ -736,7 +1068,7 @@ int test_construct_block_2()
 	iox x=iox::construct_text();
 	try
 	{
-		uint32_t a=1,b=2,c=3,d=4,e=5,f=6,g=7;
+		uint32_t a=1,c=3;
 		x.uint(6,DVB_VAR(a));
 		x.named_block_begin(2,DVB_INFO("b"));
 		x.uint(6,DVB_VAR(a));
@@ -763,6 +1095,115 @@ int test_construct_block_2()
 
 
 
+DEFTEST(test_block_deep_nesting,"test nesting of blocks beyond inline scope depth and above limit");
+MAKEDEP(test_block_deep_nesting,test_construct_block_1);
+int test_block_deep_nesting()
+{
+	const int depth=MOPA_SCOPE_INLINE_DEPTH*2+3;
+	uint8_t buf[depth+1];
+	uint8_t v=0x5a;
+	try
+	{
+		iox x=iox::construct_binary(buf,sizeof(buf));
+		for(int i=0;i<depth;i++)
+			x.named_block_begin(8,DVB_INFO("len"));
+		x.uint(8,DVB_VAR(v));
+		for(int i=0;i<depth;i++)
+			if(x.named_block_end(DVB_INFO("len"))!=(uint32_t)i+1) return -1;
+		for(int i=0;i<depth;i++)
+			if(buf[i]!=depth-i) return -2;
+		iox y=iox::parse_binary(buf,sizeof(buf));
+		v=0;
+		for(int i=0;i<depth;i++)
+			y.named_block_begin(8,DVB_INFO("len"));
+		y.uint(8,DVB_VAR(v));
+		for(int i=0;i<depth;i++)
+			y.named_block_end(DVB_INFO("len"));
+		if(v!=0x5a) return -3;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -4;
+	}
+	uint8_t big[MOPA_SCOPE_MAX_DEPTH+1];
+	int i=0;
+	try
+	{
+		iox x=iox::construct_binary(big,sizeof(big));
+		for(i=0;i<=MOPA_SCOPE_MAX_DEPTH;i++)
+			x.named_block_begin(8,DVB_INFO("len"));
+		return -5;
+	}
+	catch(const Exception& e)
+	{
+		if(i!=MOPA_SCOPE_MAX_DEPTH) return -6;
+	}
+	return 0;
+}
+
+DEFTEST(test_text_block_lengths,"test lengths of nested and sibling named blocks in text output");
+MAKEDEP(test_text_block_lengths,test_block_deep_nesting);
+int test_text_block_lengths()
+{
+	uint8_t v=7;
+	iox x=iox::construct_text();
+	x.named_block_begin(8,DVB_INFO("a"));
+	x.uint(8,DVB_VAR(v));
+	x.named_block_begin(8,DVB_INFO("b"));
+	x.uint(8,DVB_VAR(v));
+	x.named_block_end(DVB_INFO("b"));
+	x.named_block_begin(8,DVB_INFO("c"));
+	x.named_block_end(DVB_INFO("c"));
+	x.named_block_end(DVB_INFO("a"));
+	const char* expected=
+			"a:4\n"
+			"{\n"
+			"  v:7\n"
+			"  b:1\n"
+			"  {\n"
+			"    v:7\n"
+			"  }\n"
+			"  c:0\n"
+			"  {\n"
+			"  }\n"
+			"}\n";
+	if(x.as_ocx().ctx->prod!=expected)
+	{
+		printf("%s",x.as_ocx().ctx->prod.c_str());
+		return -1;
+	}
+	//many sibling blocks inside one outer block, read back
+	const int N=5000;
+	x.reset_construct_text();
+	x.named_block_begin(16,DVB_INFO("a"));
+	for(int i=0;i<N;i++)
+	{
+		x.named_block_begin(8,DVB_INFO("b"));
+		x.uint(8,DVB_VAR(v));
+		x.named_block_end(DVB_INFO("b"));
+	}
+	if(x.named_block_end(DVB_INFO("a"))!=2*N) return -2;
+	try
+	{
+		iox y=iox::parse_text(x.as_ocx().ctx->prod.c_str());
+		y.named_block_begin(16,DVB_INFO("a"));
+		for(int i=0;i<N;i++)
+		{
+			y.named_block_begin(8,DVB_INFO("b"));
+			y.uint(8,DVB_VAR(v));
+			if(y.named_block_end(DVB_INFO("b"))!=1) return -3;
+		}
+		if(y.named_block_end(DVB_INFO("a"))!=2*N) return -4;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -5;
+	}
+	return 0;
+}
+
 DEFTEST(test_construct_exception_1,"manual: text of exception for value too large");
 MAKEDEP(test_construct_exception_1,test_text_uint8_t_extensive);
 int test_construct_exception_1()
@@ -865,6 +1306,42 @@ int test_construct_exception_5()
 }
 
 
+DEFTEST(test_construct_exception_6,"test exception lists innermost enclosing blocks and counts others, also when formatted later");
+MAKEDEP(test_construct_exception_6,test_construct_exception_5);
+int test_construct_exception_6()
+{
+	std::string message[2];
+	for(int defer=0;defer<2;defer++)
+	{
+		iox x=iox::construct_text();
+		x.ctx->nothrow=defer;
+		try
+		{
+			for(int i=0;i<20;i++)
+				x.named_block_begin(8,DVB_INFO("b"));
+			uint32_t a=8;
+			x.uint(3,DVB_VAR(a));
+			return -1;
+		}
+		catch(const Exception& e)
+		{
+			if(e.message.empty()==!defer) return -2;
+			message[defer]=e.error.message();
+			if(!defer && e.message!=message[defer]) return -3;
+		}
+	}
+	if(message[0]!=message[1]) return -4;
+	if(message[0].find("value 8 exceeds 3 bits when building 'a'")!=0) return -5;
+	size_t blocks=0;
+	for(size_t p=0;(p=message[0].find("\nin block 'b'",p))!=std::string::npos;p++)
+		blocks++;
+	if(blocks!=MOPA_ERROR_SCOPES) return -6;
+	char more[32];
+	snprintf(more,sizeof(more),"\nin %d more blocks",20-MOPA_ERROR_SCOPES);
+	if(message[0].find(more)!=message[0].size()-strlen(more)) return -7;
+	return 0;
+}
+
 
 DEFTEST(test_short_string_extensive_text,"extensive test for construction/parsing short string (text)");
 int test_short_string_extensive_text()
@@ -1048,6 +1525,60 @@ int test_fixed_strings_bin()
 	}
 	return 0;
 }
+DEFTEST(test_string_ref,"test strings referring to parsed buffer");
+int test_string_ref()
+{
+	const uint8_t bytes[]={0x03,'a','b','c','x','y'};
+	uint8_t out[sizeof(bytes)]={0};
+	string_ref s,f;
+	try
+	{
+		iox x=iox::parse_binary(bytes,sizeof(bytes));
+		short_string_io(x,DVB_VAR(s));
+		fixed_string_io(x,2,DVB_VAR(f));
+		if(!s.is_ref() || s.data()!=(const char*)bytes+1 || s.size()!=3) return -1;
+		if(!f.is_ref() || f.data()!=(const char*)bytes+4 || f.size()!=2) return -2;
+		if(s.str()!="abc" || f.str()!="xy") return -3;
+
+		iox y=iox::construct_binary(out,sizeof(out));
+		short_string_io(y,DVB_VAR(s));
+		fixed_string_io(y,2,DVB_VAR(f));
+		if(memcmp(bytes,out,sizeof(bytes))!=0) return -4;
+
+		iox t=iox::construct_text();
+		short_string_io(t,DVB_VAR(s));
+		fixed_string_io(t,2,DVB_VAR(f));
+		iox u=iox::parse_text(t.as_ocx().ctx->prod.c_str());
+		string_ref s1,f1;
+		short_string_io(u,s1,DVB_INFO("s"));
+		fixed_string_io(u,2,f1,DVB_INFO("f"));
+		if(s1.is_ref() || f1.is_ref()) return -5;
+		if(s1!=s || f1!=f) return -6;
+
+		string_ref o=std::string("pq");
+		iox v=iox::construct_binary(out,sizeof(out));
+		fixed_string_io(v,2,DVB_VAR(o));
+		if(out[0]!='p' || out[1]!='q') return -7;
+
+		//descriptors own their strings, they outlive parsed buffer
+		uint8_t dsc[]={0x99,0x03,'u','v','w'};
+		descriptor_vector d;
+		iox w=iox::parse_binary(dsc,sizeof(dsc));
+		d.io(w);
+		descriptor* c=d[0]->dup();
+		memset(dsc,0,sizeof(dsc));
+		if(((unknown_descriptor*)d[0])->data!="uvw") return -9;
+		if(((unknown_descriptor*)c)->data!="uvw") return -10;
+		delete c;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -8;
+	}
+	return 0;
+}
+
 DEFTEST(test_string_exception_1,"test invalid char in string");
 int test_string_exception_1()
 {
@@ -1128,6 +1659,64 @@ int test_string_exception_5()
 	return -1;
 }
 
+DEFTEST(test_iox_reset_and_move,"test iox reused with reset() and moved between objects");
+int test_iox_reset_and_move()
+{
+	const uint8_t bytes1[]={0x12,0x34};
+	const uint8_t bytes2[]={0xab,0xcd,0xef};
+	const uint8_t block[]={0x01,0x55,0x66};
+	uint8_t out[4]={0};
+	uint16_t v;
+	iox x;
+	if((uint8_t*)x.ctx<(uint8_t*)&x || (uint8_t*)x.ctx>=(uint8_t*)(&x+1)) return -1;
+	try
+	{
+		//leave context in the middle of block, reset must discard it
+		x.reset(block,sizeof(block));
+		x.named_block_begin(8,DVB_INFO("len"));
+		x.uint(8,DVB_VAR(v));
+		x.uint(8,DVB_VAR(v));
+		return -2;
+	}
+	catch(const Exception& e)
+	{
+	}
+	try
+	{
+		x.reset(bytes2,sizeof(bytes2));
+		if(x.as_ibx().ctx->scope_stack.size()!=0) return -3;
+		x.uint(16,DVB_VAR(v));
+		if(v!=0xabcd) return -3;
+		if(x.ctx->bitpos!=16) return -4;
+		x.reset(bytes1,sizeof(bytes1));
+		x.uint(16,DVB_VAR(v));
+		if(v!=0x1234) return -5;
+
+		x.reset_construct(out,sizeof(out));
+		x.uint(16,DVB_VAR(v));
+		if(out[0]!=0x12 || out[1]!=0x34) return -6;
+
+		x.reset_construct_text();
+		x.uint(16,DVB_VAR(v));
+		iox y(std::move(x));
+		if((uint8_t*)y.ctx<(uint8_t*)&y || (uint8_t*)y.ctx>=(uint8_t*)(&y+1)) return -7;
+		std::string text=y.as_ocx().ctx->prod;
+		y.reset_construct_text();
+		if(y.as_ocx().ctx->prod.size()!=0) return -8;
+
+		x=iox::parse_text(text.c_str());
+		v=0;
+		x.uint(16,DVB_VAR(v));
+		if(v!=0x1234) return -9;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -10;
+	}
+	return 0;
+}
+
 DEFTEST(test_ts_specification_1,"test ts_specification parsing binary");
 int test_ts_specification_1()
 {
@@ -1167,6 +1756,154 @@ int test_ts_specification_1()
 }
 
 
+DEFTEST(test_lazy_descriptor_vector,"test descriptor loop decoded on access and re-emitted verbatim");
+int test_lazy_descriptor_vector()
+{
+	const uint8_t bytes[]={
+			0x41,0x03,0x00,0x01,0x19,
+			0x99,0x02,0xaa,0xbb,
+			0x44,0x0b,0x03,0x12,0x00,0x00,0xff,0xf2,0x03,0x00,0x69,0x00,0x05};
+	uint8_t out[sizeof(bytes)];
+	uint8_t out2[sizeof(bytes)];
+	try
+	{
+		lazy_descriptor_vector D;
+		iox x=iox::parse_binary(bytes,sizeof(bytes));
+		D.io(x);
+		if(D.size()!=3) return -1;
+		if(D.tag(0)!=0x41 || D.tag(1)!=0x99 || D.tag(2)!=0x44) return -2;
+		for(size_t i=0;i<D.size();i++)
+			if(D.is_decoded(i)) return -3;
+		if(D.find(0x5a)!=NULL) return -4;
+		cable_delivery_system_descriptor* c=dynamic_cast<cable_delivery_system_descriptor*>(D.find(0x44));
+		if(c==NULL) return -5;
+		if(c->frequency!=0x03120000 || c->FEC_outer!=2 || c->modulation!=3) return -6;
+		if(c->symbol_rate!=0x0069000 || c->FEC_inner!=5) return -7;
+		if(D.is_decoded(0) || D.is_decoded(1) || !D.is_decoded(2)) return -8;
+
+		iox y=iox::construct_binary(out,sizeof(out));
+		D.io(y);
+		if(y.ctx->bitpos!=sizeof(bytes)*8) return -9;
+		if(memcmp(out,bytes,sizeof(bytes))!=0) return -10;
+
+		c->modulation=5;
+		iox z=iox::construct_binary(out,sizeof(out));
+		D.io(z);
+		for(size_t i=0;i<sizeof(bytes);i++)
+			if(out[i]!=(i==17?0x05:bytes[i])) return -11;
+
+		iox t=iox::construct_text();
+		D.io(t);
+		lazy_descriptor_vector E;
+		iox u=iox::parse_text(t.as_ocx().ctx->prod.c_str());
+		E.io(u);
+		iox v=iox::construct_binary(out2,sizeof(out2));
+		E.io(v);
+		if(memcmp(out,out2,sizeof(out))!=0) return -12;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -13;
+	}
+	try
+	{
+		lazy_descriptor_vector D;
+		iox x=iox::parse_binary(bytes,sizeof(bytes)-1);
+		D.io(x);
+		return -14;
+	}
+	catch(const Exception& e)
+	{
+	}
+	return 0;
+}
+
+struct lazy_ts_specification
+{
+	uint16_t transport_stream_id;
+	uint16_t original_network_id;
+	uint16_t transport_descriptors_length;
+	lazy_descriptor_vector transport_descriptors;
+	template<class X>
+	void io(X& x)
+	{
+		record<X> r(x,48,DVB_INFO("ts_specification"));
+		r.template uint<16>(DVB_VAR(transport_stream_id));
+		r.template uint<16>(DVB_VAR(original_network_id));
+		r.template uint_req<4,0xf>(DVB_INFO("reserved_future_use"));
+		r.named_block_begin(12,DVB_INFO("transport_descriptors_length"));
+		transport_descriptors.io(x);
+		transport_descriptors_length=x.named_block_end(DVB_INFO("transport_descriptors"));
+	}
+};
+
+DEFTEST(test_lazy_descriptor_vector_block,"test descriptor loop re-emitted verbatim inside length block");
+int test_lazy_descriptor_vector_block()
+{
+	const uint8_t bytes[]={
+			0x12,0x34,0x56,0x78,0xf0,0x09,
+			0x41,0x03,0x00,0x01,0x19,
+			0x99,0x02,0xaa,0xbb,
+			0x77};
+	uint8_t out[sizeof(bytes)];
+	try
+	{
+		lazy_ts_specification T;
+		uint8_t tail;
+		iox x=iox::parse_binary(bytes,sizeof(bytes));
+		T.io(x);
+		x.uint<8>(DVB_VAR(tail));
+		if(T.transport_descriptors.size()!=2) return -1;
+
+		memset(out,0xee,sizeof(out));
+		iox y=iox::construct_binary(out,sizeof(out));
+		T.io(y);
+		y.uint<8>(DVB_VAR(tail));
+		if(y.ctx->bitpos!=sizeof(bytes)*8) return -2;
+		if(memcmp(out,bytes,sizeof(bytes))!=0) return -3;
+
+		if(T.transport_descriptors.at(1)==NULL) return -4;
+		memset(out,0xee,sizeof(out));
+		iox z=iox::construct_binary(out,sizeof(out));
+		T.io(z);
+		z.uint<8>(DVB_VAR(tail));
+		if(memcmp(out,bytes,sizeof(bytes))!=0) return -5;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -6;
+	}
+	//cable_delivery_system_descriptor with one trailing byte it does not consume
+	const uint8_t loose[]={
+			0x44,0x0c,0x03,0x12,0x00,0x00,0xff,0xf2,0x03,0x00,0x69,0x00,0x05,0x00};
+	try
+	{
+		lazy_descriptor_vector D;
+		iox x=iox::parse_binary(loose,sizeof(loose));
+		D.io(x);
+		if(D.size()!=1) return -7;
+		D.at(0);
+		return -8;
+	}
+	catch(const Exception& e)
+	{
+		if(e.error.code!=ERR_BLOCK) return -9;
+	}
+	//validation decodes content, as eager loop does
+	for(int lazy=0;lazy<2;lazy++)
+	{
+		lazy_descriptor_vector L;
+		descriptor_vector D;
+		iox v=iox::validate_binary(loose,sizeof(loose));
+		io_error err;
+		if(lazy?try_io(v,L,&err):try_io(v,D,&err)) return -10-lazy;
+		if(err.code!=ERR_BLOCK) return -12-lazy;
+	}
+	return 0;
+}
+
 DEFTEST(test_nit_table_parsing_1,"test parsing of example NIT tables");
 int test_nit_table_parsing_1()
 {
@@ -1221,17 +1958,1858 @@ int test_nit_table_parsing_1()
 	return 0;
 }
 
-DEFTEST(test_nit_table_parsing_2,"test parsing of example NIT table with error injections");
-MAKEDEP(test_nit_table_parsing_2,test_nit_table_parsing_1);
-int test_nit_table_parsing_2()
+DEFTEST(test_nit_table_static_modes,"test NIT round trip with io() instantiated for ibx, ocx, icx, obx");
+MAKEDEP(test_nit_table_static_modes,test_nit_table_parsing_1);
+int test_nit_table_static_modes()
 {
-	for(int iter=0;iter<100;iter++)
-	{
-		int fd;
+	const char* FILES[]={
+			"tests/data/Bromley_NIT.sec",
+			"tests/data/BBC_NIT.sec",
+			"tests/data/MUX1_NIT.sec",
+			"tests/data/MUX3_NIT.sec"};
+	int file;
+	for(file=0;file<(int)(sizeof(FILES)/sizeof(*FILES));file++)
+	{
+		int fd;
+		fd=open(FILES[file],O_RDONLY);
+		if(fd<0) return -10000*file-1;
+		uint8_t data[2000];
+		uint8_t out[2000];
+		int r;
+		r=read(fd,data,2000);
+		close(fd);
+
+		iox x=iox::parse_binary(data,r);
+		iox y=iox::construct_text();
+		iox y_ref=iox::construct_text();
+		try
+		{
+			struct network_information_section T={0};
+			ibx xb=x.as_ibx();
+			T.io(xb);
+			ocx yc=y.as_ocx();
+			T.io(yc);
+			T.io(y_ref);
+			if(yc.ctx->prod!=y_ref.as_ocx().ctx->prod) return -10000*file-3;
+
+			iox z=iox::parse_text(yc.ctx->prod.c_str());
+			iox v=iox::construct_binary(out,sizeof(out));
+			struct network_information_section T1={0};
+			icx zc=z.as_icx();
+			T1.io(zc);
+			obx vb=v.as_obx();
+			T1.io(vb);
+			int i;
+			int R=vb.ctx->bitpos/8;
+			if(r!=R) return -10000*file-1000;
+			for(i=0;i<R;i++)
+				if(data[i]!=out[i]) return -10000*file-1000-i;
+		}
+		catch(const Exception& e)
+		{
+			printf("%s\n",e.message.c_str());
+			return -10000*file-2;
+		}
+	}
+	return 0;
+}
+
+DEFTEST(test_nit_table_projection,"test NIT header-only projection parse");
+MAKEDEP(test_nit_table_projection,test_nit_table_parsing_1);
+int test_nit_table_projection()
+{
+	const char* FILES[]={
+			"tests/data/Bromley_NIT.sec",
+			"tests/data/BBC_NIT.sec",
+			"tests/data/MUX1_NIT.sec",
+			"tests/data/MUX3_NIT.sec"};
+	int file;
+	for(file=0;file<(int)(sizeof(FILES)/sizeof(*FILES));file++)
+	{
+		int fd;
+		fd=open(FILES[file],O_RDONLY);
+		if(fd<0) return -10000*file-1;
+		uint8_t data[2000];
+		int r;
+		r=read(fd,data,2000);
+		close(fd);
+
+		try
+		{
+			struct network_information_section T={0};
+			iox x=iox::parse_binary(data,r);
+			T.io(x);
+			struct network_information_section P={0};
+			iox y=iox::parse_binary(data,r);
+			ipx p=y.as_ipx();
+			P.io(p);
+			if(y.ctx->bitpos!=(uint32_t)r*8) return -10000*file-3;
+			if(P.table_id!=T.table_id) return -10000*file-4;
+			if(P.network_id!=T.network_id) return -10000*file-5;
+			if(P.version_number!=T.version_number) return -10000*file-6;
+			if(P.section_number!=T.section_number) return -10000*file-7;
+			if(P.last_section_number!=T.last_section_number) return -10000*file-8;
+			if(P.CRC!=T.CRC) return -10000*file-9;
+			if(P.network_descriptors_length!=T.network_descriptors_length) return -10000*file-10;
+			if(P.transport_stream_loop_length!=T.transport_stream_loop_length) return -10000*file-11;
+			if(P.network_descriptors.size()!=0 || P.ts_loop.size()!=0) return -10000*file-12;
+			if(T.ts_loop.size()==0) return -10000*file-13;
+		}
+		catch(const Exception& e)
+		{
+			printf("%s\n",e.message.c_str());
+			return -10000*file-2;
+		}
+	}
+	return 0;
+}
+
+DEFTEST(test_nit_table_validation,"test NIT validation agrees with parsing for any bit change");
+MAKEDEP(test_nit_table_validation,test_nit_table_parsing_1);
+int test_nit_table_validation()
+{
+	int fd;
+	fd=open("tests/data/Bromley_NIT.sec",O_RDONLY);
+	if(fd<0) return -1;
+	uint8_t data[2000];
+	int r;
+	r=read(fd,data,2000);
+	close(fd);
+	if(r!=715) return -2;
+	for(int iter=-1;iter<r*8;iter++)
+	{
+		if(iter>=0)
+			data[iter/8]^=1<<(iter&7);
+		bool parse_ok=true;
+		bool validate_ok=true;
+		struct network_information_section T={0};
+		try
+		{
+			iox x=iox::parse_binary(data,r);
+			T.io(x);
+		}
+		catch(const Exception& e)
+		{
+			parse_ok=false;
+		}
+		struct network_information_section V={0};
+		try
+		{
+			iox y=iox::validate_binary(data,r);
+			V.io(y);
+		}
+		catch(const Exception& e)
+		{
+			validate_ok=false;
+		}
+		if(parse_ok!=validate_ok) return -1000-iter;
+		if(V.network_descriptors.size()!=0 || V.ts_loop.size()!=0) return -3;
+		if(iter==-1)
+		{
+			if(!validate_ok) return -4;
+			iox z=iox::validate_binary(data,r);
+			ivx zv=z.as_ivx();
+			V.io(zv);
+			if(z.ctx->bitpos!=(uint32_t)r*8) return -5;
+			if(V.network_descriptors.size()!=0 || V.ts_loop.size()!=0) return -6;
+		}
+		if(iter>=0)
+			data[iter/8]^=1<<(iter&7);
+	}
+	return 0;
+}
+
+DEFTEST(test_nit_table_measure,"test NIT measured size equals constructed size");
+MAKEDEP(test_nit_table_measure,test_nit_table_parsing_1);
+int test_nit_table_measure()
+{
+	const char* FILES[]={
+			"tests/data/Bromley_NIT.sec",
+			"tests/data/BBC_NIT.sec",
+			"tests/data/MUX1_NIT.sec",
+			"tests/data/MUX3_NIT.sec"};
+	int file;
+	for(file=0;file<(int)(sizeof(FILES)/sizeof(*FILES));file++)
+	{
+		int fd;
+		fd=open(FILES[file],O_RDONLY);
+		if(fd<0) return -10000*file-1;
+		uint8_t data[2000];
+		int r;
+		r=read(fd,data,2000);
+		close(fd);
+		try
+		{
+			struct network_information_section T={0};
+			iox x=iox::parse_binary(data,r);
+			T.io(x);
+
+			iox m=iox::measure_binary();
+			T.io(m);
+			if(m.ctx->bitpos!=(uint32_t)r*8) return -10000*file-3;
+			m.reset_measure();
+			omx mm=m.as_omx();
+			T.io(mm);
+			if(mm.ctx->bitpos!=(uint32_t)r*8) return -10000*file-4;
+
+			std::vector<uint8_t> out(m.ctx->bitpos/8);
+			iox y=iox::construct_binary(out.data(),out.size());
+			T.io(y);
+			if(y.ctx->bitpos!=(uint32_t)r*8) return -10000*file-5;
+			if(memcmp(out.data(),data,r)!=0) return -10000*file-6;
+
+			iox small=iox::measure_binary(r-1);
+			try
+			{
+				T.io(small);
+				return -10000*file-7;
+			}
+			catch(const Exception& e)
+			{}
+
+			//grow transport stream loop until NIT exceeds 1024 bytes
+			try
+			{
+				while(T.ts_loop.size()<100)
+				{
+					T.ts_loop.push_back(T.ts_loop[0]);
+					m.reset_measure();
+					T.io(m);
+				}
+				return -10000*file-8;
+			}
+			catch(const Exception& e)
+			{
+				if(e.message.find("NIT size exceeds 1024")==std::string::npos) return -10000*file-9;
+			}
+		}
+		catch(const Exception& e)
+		{
+			printf("%s\n",e.message.c_str());
+			return -10000*file-2;
+		}
+	}
+	return 0;
+}
+
+DEFTEST(test_nit_table_try_io,"test NIT error record from try_io agrees with exception");
+MAKEDEP(test_nit_table_try_io,test_nit_table_parsing_1);
+int test_nit_table_try_io()
+{
+	int fd;
+	fd=open("tests/data/Bromley_NIT.sec",O_RDONLY);
+	if(fd<0) return -1;
+	uint8_t data[2000];
+	int r;
+	r=read(fd,data,2000);
+	close(fd);
+	if(r!=715) return -2;
+	iox x;
+	for(int iter=-1;iter<r*8;iter++)
+	{
+		if(iter>=0)
+			data[iter/8]^=1<<(iter&7);
+		std::string message;
+		struct network_information_section T={0};
+		try
+		{
+			x.reset(data,r);
+			T.io(x);
+		}
+		catch(const Exception& e)
+		{
+			message=e.message;
+			if(e.error.message()!=message) return -3;
+		}
+		io_error err;
+		x.reset(data,r);
+		bool ok=try_io(x,T,&err);
+		if(ok!=message.empty()) return -1000-iter;
+		if(!ok)
+		{
+			if(err.message()!=message) return -100000-iter;
+			if(err.code==ERR_OTHER) return -200000-iter;
+		}
+		if(x.ctx->nothrow || x.ctx->failed) return -4;
+		if(iter>=0)
+			data[iter/8]^=1<<(iter&7);
+	}
+	//last bit of CRC
+	data[r-1]^=1;
+	io_error err;
+	x.reset(data,r);
+	ibx xb=x.as_ibx();
+	struct network_information_section T={0};
+	if(try_io(xb,T,&err)) return -5;
+	if(err.code!=ERR_CRC) return -6;
+	data[r-1]^=1;
+	//text parsing, every 7th character changed
+	x.reset(data,r);
+	T.io(x);
+	x.reset_construct_text();
+	T.io(x);
+	std::string text=((ocCtx*)x.ctx)->prod;
+	for(size_t i=0;i<text.size();i+=7)
+	{
+		std::string t=text;
+		t[i]='#';
+		std::string message;
+		struct network_information_section U={0};
+		try
+		{
+			x.reset(t.data(),t.size());
+			U.io(x);
+		}
+		catch(const Exception& e)
+		{
+			message=e.message;
+		}
+		x.reset(t.data(),t.size());
+		bool ok=try_io(x,U,&err);
+		if(ok!=message.empty()) return -7;
+		if(!ok && err.message()!=message) return -8;
+	}
+	return 0;
+}
+
+DEFTEST(test_nit_table_text_sink,"test NIT text construction into sink");
+MAKEDEP(test_nit_table_text_sink,test_nit_table_parsing_1);
+static void test_text_sink_collect(void* ctx,const char* text,size_t len)
+{
+	std::vector<std::string>* chunks=(std::vector<std::string>*)ctx;
+	chunks->push_back(std::string(text,len));
+}
+static void test_text_sink_count(void* ctx,const char*,size_t len)
+{
+	*(size_t*)ctx+=len;
+}
+int test_nit_table_text_sink()
+{
+	const char* FILES[]={
+			"tests/data/Bromley_NIT.sec",
+			"tests/data/BBC_NIT.sec",
+			"tests/data/MUX1_NIT.sec",
+			"tests/data/MUX3_NIT.sec"};
+	std::string ref;
+	std::vector<std::string> chunks;
+	FILE* f=tmpfile();
+	if(f==NULL) return -1;
+	{
+		iox y=iox::construct_text(test_text_sink_collect,&chunks,1);
+		iox z=iox::construct_text(text_sink_file,f);
+		for(int file=0;file<(int)(sizeof(FILES)/sizeof(*FILES));file++)
+		{
+			int fd;
+			fd=open(FILES[file],O_RDONLY);
+			if(fd<0) return -10000*file-1;
+			uint8_t data[2000];
+			int r;
+			r=read(fd,data,2000);
+			close(fd);
+			try
+			{
+				struct network_information_section T={0};
+				iox x=iox::parse_binary(data,r);
+				T.io(x);
+				iox t=iox::construct_text();
+				T.io(t);
+				ref+=t.as_ocx().ctx->prod;
+				size_t before=chunks.size();
+				T.io(y);
+				if(chunks.size()==before) return -10000*file-3;
+				if(!y.as_ocx().ctx->prod.empty()) return -10000*file-4;
+				T.io(z);
+			}
+			catch(const Exception& e)
+			{
+				printf("%s\n",e.message.c_str());
+				return -10000*file-2;
+			}
+		}
+	}
+	std::string all;
+	for(size_t i=0;i<chunks.size();i++)
+		all+=chunks[i];
+	if(all!=ref) return -2;
+	//remaining text is passed to file when z is destroyed
+	std::string written(ref.size()+1,0);
+	rewind(f);
+	size_t n=fread(&written[0],1,written.size(),f);
+	fclose(f);
+	written.resize(n);
+	if(written!=ref) return -3;
+	//long stream: size limit must apply to each section, not to whole output
+	int fd=open(FILES[0],O_RDONLY);
+	if(fd<0) return -4;
+	uint8_t data[2000];
+	int r=read(fd,data,2000);
+	close(fd);
+	const uint32_t CHUNK_SIZES[]={MOPA_TEXT_CHUNK,1<<30};
+	for(size_t c=0;c<sizeof(CHUNK_SIZES)/sizeof(*CHUNK_SIZES);c++)
+	{
+		size_t total=0;
+		size_t one;
+		try
+		{
+			struct network_information_section T={0};
+			iox x=iox::parse_binary(data,r);
+			T.io(x);
+			iox t=iox::construct_text();
+			T.io(t);
+			one=t.as_ocx().ctx->prod.size();
+			iox y=iox::construct_text(test_text_sink_count,&total,CHUNK_SIZES[c]);
+			for(int i=0;i<3000;i++)
+				T.io(y);
+			y.as_ocx().ctx->flush();
+		}
+		catch(const Exception& e)
+		{
+			printf("%s\n",e.message.c_str());
+			return -5-c;
+		}
+		if(total!=3000*one) return -7;
+	}
+	return 0;
+}
+
+DEFTEST(test_eit_table_parsing_1,"test parsing of example EIT tables");
+int test_eit_table_parsing_1()
+{
+	const char* FILES[]={
+			"tests/data/Bromley_EIT.sec",
+			"tests/data/MUX1_EIT.sec",
+			"tests/data/MUX3_EIT.sec"};
+	int file;
+	for(file=0;file<(int)(sizeof(FILES)/sizeof(*FILES));file++)
+	{
+		int fd;
+		fd=open(FILES[file],O_RDONLY);
+		if(fd<0) return -10000*file-1;
+		uint8_t data[4096];
+		uint8_t out[4096];
+		int r;
+		r=read(fd,data,sizeof(data));
+		close(fd);
+
+		iox x=iox::parse_binary(data,r);
+		iox y=iox::construct_text();
+		struct event_information_section T={0};
+		try
+		{
+			T.io(x);
+			if(x.ctx->bitpos!=(uint32_t)r*8) return -10000*file-3;
+			if(T.events.size()==0) return -10000*file-4;
+			T.io(y);
+			iox z=iox::parse_text(y.as_ocx().ctx->prod.c_str());
+			iox v=iox::construct_binary(out,sizeof(out));
+			struct event_information_section T1={0};
+			T1.io(z);
+			if(T1.events.size()!=T.events.size()) return -10000*file-5;
+			T1.io(v);
+			int i;
+			int R=v.as_obx().ctx->bitpos/8;
+			if(r!=R) return -10000*file-1000;
+			for(i=0;i<R;i++)
+				if(data[i]!=out[i]) return -10000*file-1000-i;
+		}
+		catch(const Exception& e)
+		{
+			printf("%s\n",e.message.c_str());
+			return -10000*file-2;
+		}
+	}
+	return 0;
+}
+
+DEFTEST(test_eit_table_static_modes,"test EIT round trip with io() instantiated for ibx, ocx, icx, obx");
+MAKEDEP(test_eit_table_static_modes,test_eit_table_parsing_1);
+int test_eit_table_static_modes()
+{
+	const char* FILES[]={
+			"tests/data/Bromley_EIT.sec",
+			"tests/data/MUX1_EIT.sec",
+			"tests/data/MUX3_EIT.sec"};
+	int file;
+	for(file=0;file<(int)(sizeof(FILES)/sizeof(*FILES));file++)
+	{
+		int fd;
+		fd=open(FILES[file],O_RDONLY);
+		if(fd<0) return -10000*file-1;
+		uint8_t data[4096];
+		uint8_t out[4096];
+		int r;
+		r=read(fd,data,sizeof(data));
+		close(fd);
+
+		iox x=iox::parse_binary(data,r);
+		iox y=iox::construct_text();
+		iox y_ref=iox::construct_text();
+		try
+		{
+			struct event_information_section T={0};
+			ibx xb=x.as_ibx();
+			T.io(xb);
+			ocx yc=y.as_ocx();
+			T.io(yc);
+			T.io(y_ref);
+			if(yc.ctx->prod!=y_ref.as_ocx().ctx->prod) return -10000*file-3;
+
+			iox z=iox::parse_text(yc.ctx->prod.c_str());
+			iox v=iox::construct_binary(out,sizeof(out));
+			struct event_information_section T1={0};
+			icx zc=z.as_icx();
+			T1.io(zc);
+			obx vb=v.as_obx();
+			T1.io(vb);
+			int i;
+			int R=vb.ctx->bitpos/8;
+			if(r!=R) return -10000*file-1000;
+			for(i=0;i<R;i++)
+				if(data[i]!=out[i]) return -10000*file-1000-i;
+		}
+		catch(const Exception& e)
+		{
+			printf("%s\n",e.message.c_str());
+			return -10000*file-2;
+		}
+	}
+	return 0;
+}
+
+DEFTEST(test_eit_table_measure,"test EIT measured size equals constructed size");
+MAKEDEP(test_eit_table_measure,test_eit_table_parsing_1);
+int test_eit_table_measure()
+{
+	const char* FILES[]={
+			"tests/data/Bromley_EIT.sec",
+			"tests/data/MUX1_EIT.sec",
+			"tests/data/MUX3_EIT.sec"};
+	int file;
+	for(file=0;file<(int)(sizeof(FILES)/sizeof(*FILES));file++)
+	{
+		int fd;
+		fd=open(FILES[file],O_RDONLY);
+		if(fd<0) return -10000*file-1;
+		uint8_t data[4096];
+		int r;
+		r=read(fd,data,sizeof(data));
+		close(fd);
+		try
+		{
+			struct event_information_section T={0};
+			iox x=iox::parse_binary(data,r);
+			T.io(x);
+
+			iox m=iox::measure_binary();
+			T.io(m);
+			if(m.ctx->bitpos!=(uint32_t)r*8) return -10000*file-3;
+
+			std::vector<uint8_t> out(m.ctx->bitpos/8);
+			iox y=iox::construct_binary(out.data(),out.size());
+			T.io(y);
+			if(y.ctx->bitpos!=(uint32_t)r*8) return -10000*file-4;
+			if(memcmp(out.data(),data,r)!=0) return -10000*file-5;
+
+			//repeat events until they do not fit in 12 bit section_length
+			try
+			{
+				while(T.events.size()<1000)
+				{
+					T.events.push_back(T.events[0]);
+					m.reset_measure();
+					T.io(m);
+				}
+				return -10000*file-6;
+			}
+			catch(const Exception& e)
+			{
+				if(e.message.find("in block 'section_length'")==std::string::npos) return -10000*file-7;
+			}
+		}
+		catch(const Exception& e)
+		{
+			printf("%s\n",e.message.c_str());
+			return -10000*file-2;
+		}
+	}
+	return 0;
+}
+
+DEFTEST(test_eit_table_validation,"test EIT validation agrees with parsing for any bit change");
+MAKEDEP(test_eit_table_validation,test_eit_table_parsing_1);
+int test_eit_table_validation()
+{
+	int fd;
+	fd=open("tests/data/Bromley_EIT.sec",O_RDONLY);
+	if(fd<0) return -1;
+	uint8_t data[4096];
+	int r;
+	r=read(fd,data,sizeof(data));
+	close(fd);
+	if(r!=245) return -2;
+	for(int iter=-1;iter<r*8;iter++)
+	{
+		if(iter>=0)
+			data[iter/8]^=1<<(iter&7);
+		bool parse_ok=true;
+		bool validate_ok=true;
+		struct event_information_section T={0};
+		try
+		{
+			iox x=iox::parse_binary(data,r);
+			T.io(x);
+		}
+		catch(const Exception& e)
+		{
+			parse_ok=false;
+		}
+		struct event_information_section V={0};
+		try
+		{
+			iox y=iox::validate_binary(data,r);
+			V.io(y);
+		}
+		catch(const Exception& e)
+		{
+			validate_ok=false;
+		}
+		if(parse_ok!=validate_ok) return -1000-iter;
+		if(V.events.size()!=0) return -3;
+		if(iter>=0)
+			data[iter/8]^=1<<(iter&7);
+	}
+	return 0;
+}
+
+DEFTEST(test_text_format_speed,"test text of NIT and EIT corpus is produced at least 3 times faster than with sprintf and per-field appends");
+MAKEDEP(test_text_format_speed,test_nit_table_text_sink);
+static double test_now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+/**
+ * Integer line as formatted before lookup tables, with sprintf and appends per field.
+ */
+static void test_format_uint_reference(std::string& out, uint32_t depth, int bitsize, uint64_t value, const iox_info* info)
+{
+	char buf[70];
+	out.append(depth*2,' ');
+	out+=info->name;
+	out+=":";
+	uint32_t fmt=info->hint&FORMAT_HINT_MASK;
+	if(fmt==FORMAT_HINT_HEX)
+		sprintf(buf,"0x%llx",(unsigned long long)value);
+	else if(fmt==FORMAT_HINT_BIN)
+	{
+		buf[0]='0';
+		buf[1]='b';
+		for(int i=0;i<bitsize;i++)
+			buf[2+i]=(value&(1ULL<<(bitsize-1-i)))?'1':'0';
+		buf[2+bitsize]=0;
+	}
+	else
+		sprintf(buf,"%llu",(unsigned long long)value);
+	out+=buf;
+	out+="\n";
+}
+/**
+ * String line as formatted before lookup tables, escaped character by character.
+ */
+static void test_produce_string_reference(std::string& s, uint32_t depth, const char* str, uint32_t len, const iox_info* info)
+{
+	s.append(depth*2,' ');
+	s+=info->name;
+	s+=":'";
+	for(uint32_t i=0;i<len;i++)
+	{
+		uint8_t c=str[i];
+		if(c=='\'' || c=='\\' || c=='\r' || c=='\n')
+		{
+			s+="\\";s+=c;
+			continue;
+		}
+		if(c>=32 && c<127)
+		{
+			s+=c;
+			continue;
+		}
+		s+='\\';
+		s+=('0'+((c>>6)&0x7));
+		s+=('0'+((c>>3)&0x7));
+		s+=('0'+((c>>0)&0x7));
+	}
+	s+="'\n";
+}
+/**
+ * Single line of constructed text: block begin '{', block end '}', integer 'u' or string 's'.
+ */
+struct test_text_op
+{
+	char kind;
+	int bitsize;
+	uint64_t value;
+	std::string name;
+	std::string str;
+	iox_info info;
+};
+/**
+ * Splits constructed text into lines that produce it again.
+ * \return false if text has line it does not understand
+ */
+static bool test_text_ops(const std::string& text,std::vector<test_text_op>& ops)
+{
+	size_t pos=0;
+	while(pos<text.size())
+	{
+		test_text_op op={0,0,0};
+		op.info.file=__FILE__;
+		op.info.line=__LINE__;
+		op.info.hint=FORMAT_NOHINT;
+		while(text[pos]==' ')
+			pos++;
+		if(text[pos]=='{' || text[pos]=='}')
+		{
+			op.kind=text[pos];
+			pos+=2;
+			ops.push_back(op);
+			continue;
+		}
+		size_t colon=text.find(':',pos);
+		if(colon==std::string::npos) return false;
+		op.name=text.substr(pos,colon-pos);
+		pos=colon+1;
+		if(text[pos]=='\'')
+		{
+			op.kind='s';
+			pos++;
+			while(text[pos]!='\'')
+			{
+				char c=text[pos++];
+				if(c=='\\')
+				{
+					c=text[pos++];
+					if(c>='0' && c<='7')
+					{
+						c=(c-'0')*64+(text[pos]-'0')*8+(text[pos+1]-'0');
+						pos+=2;
+					}
+				}
+				op.str+=c;
+			}
+			pos++;
+		}
+		else
+		{
+			op.kind='u';
+			op.bitsize=64;
+			if(text.compare(pos,2,"0x")==0)
+			{
+				op.info.hint=FORMAT_HINT_HEX;
+				op.value=strtoull(text.c_str()+pos+2,NULL,16);
+			}
+			else if(text.compare(pos,2,"0b")==0)
+			{
+				op.info.hint=FORMAT_HINT_BIN;
+				op.bitsize=strspn(text.c_str()+pos+2,"01");
+				op.value=strtoull(text.c_str()+pos+2,NULL,2);
+			}
+			else
+				op.value=strtoull(text.c_str()+pos,NULL,10);
+			pos=text.find('\n',pos);
+			if(pos==std::string::npos) return false;
+		}
+		if(text[pos]!='\n') return false;
+		pos++;
+		ops.push_back(op);
+	}
+	//names move with vector, so they are referenced only when it is complete
+	for(size_t i=0;i<ops.size();i++)
+		ops[i].info.name=ops[i].name.c_str();
+	return true;
+}
+/**
+ * Produces lines of \b ops with text construction facade, returns seconds spent.
+ */
+static double test_text_replay(iox& x,std::vector<test_text_op>& ops,std::string& text)
+{
+	double t0=test_now();
+	x.reset_construct_text();
+	ocx o=x.as_ocx();
+	for(size_t i=0;i<ops.size();i++)
+	{
+		test_text_op& op=ops[i];
+		switch(op.kind)
+		{
+		case '{':
+			o.block_begin(0xffff,NULL);
+			break;
+		case '}':
+			o.block_end(NULL);
+			break;
+		case 'u':
+			o.uint(op.bitsize,op.value,&op.info);
+			break;
+		default:
+			fixed_string_io(o,op.str.size(),op.str,&op.info);
+		}
+	}
+	double t=test_now()-t0;
+	text.swap(o.ctx->prod);
+	return t;
+}
+/**
+ * Produces lines of \b ops with reference formatting, returns seconds spent.
+ */
+static double test_text_replay_reference(const std::vector<test_text_op>& ops,std::string& text)
+{
+	double t0=test_now();
+	text.clear();
+	uint32_t depth=0;
+	for(size_t i=0;i<ops.size();i++)
+	{
+		const test_text_op& op=ops[i];
+		switch(op.kind)
+		{
+		case '{':
+			text.append(depth*2,' ');
+			text+="{\n";
+			depth++;
+			break;
+		case '}':
+			depth--;
+			text.append(depth*2,' ');
+			text+="}\n";
+			break;
+		case 'u':
+			test_format_uint_reference(text,depth,op.bitsize,op.value,&op.info);
+			break;
+		default:
+			test_produce_string_reference(text,depth,op.str.data(),op.str.size(),&op.info);
+		}
+	}
+	return test_now()-t0;
+}
+int test_text_format_speed()
+{
+	const iox_info* infos[3]={
+			DVB_INFO_HINT("v",FORMAT_HINT_DEC),
+			DVB_INFO_HINT("v",FORMAT_HINT_HEX),
+			DVB_INFO_HINT("v",FORMAT_HINT_BIN)};
+	const int N=30000;
+	std::vector<uint64_t> values(N);
+	std::vector<int> sizes(N);
+	uint64_t seed=0x123456789abcdefULL;
+	for(int i=0;i<N;i++)
+	{
+		seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+		sizes[i]=1+(seed>>58);
+		values[i]=seed & (sizes[i]==64?~0ULL:(1ULL<<sizes[i])-1);
+		if(i&1) values[i]>>=(seed>>20)%sizes[i];
+	}
+	iox x=iox::construct_text();
+	ocCtx* ctx=x.as_ocx().ctx;
+	std::string ref;
+	for(int h=0;h<3;h++)
+	{
+		ctx->prod.clear();
+		ref.clear();
+		for(int i=0;i<N;i++)
+		{
+			ctx->write_uint(sizes[i],values[i],infos[h]);
+			test_format_uint_reference(ref,0,sizes[i],values[i],infos[h]);
+		}
+		if(ctx->prod!=ref) return -1-h;
+	}
+
+	//binary hint reads back
+	try
+	{
+		for(int i=0;i<100;i++)
+		{
+			x.reset_construct_text();
+			x.as_ocx().uint(sizes[i],values[i],infos[2]);
+			iox y=iox::parse_text(ctx->prod.c_str());
+			uint64_t v;
+			y.uint(sizes[i],v,infos[2]);
+			if(v!=values[i]) return -4;
+		}
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -5;
+	}
+
+	//strings escape as in reference, across 16-byte blocks and beyond stack line
+	try
+	{
+		std::string chars;
+		for(int len=0;len<600;len+=(len<80?1:37))
+		{
+			chars.resize(len);
+			for(int i=0;i<len;i++)
+			{
+				seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+				chars[i]=(seed>>60)==0?(char)(seed>>52):(char)(32+(seed>>40)%95);
+			}
+			x.reset_construct_text();
+			fixed_string_io(x,len,chars,DVB_INFO("s"));
+			ref.clear();
+			test_produce_string_reference(ref,0,chars.data(),len,DVB_INFO("s"));
+			if(ctx->prod!=ref) return -6;
+			iox y=iox::parse_text(ctx->prod.c_str());
+			std::string back;
+			fixed_string_io(y,len,back,DVB_INFO("s"));
+			if(back!=chars) return -7;
+		}
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -8;
+	}
+
+	//lines of NIT and EIT corpus text are produced again by both formatters
+	const char* FILES[]={
+			"tests/data/Bromley_NIT.sec",
+			"tests/data/BBC_NIT.sec",
+			"tests/data/MUX1_NIT.sec",
+			"tests/data/MUX3_NIT.sec",
+			"tests/data/Bromley_EIT.sec",
+			"tests/data/MUX1_EIT.sec",
+			"tests/data/MUX3_EIT.sec"};
+	const size_t NITS=4;
+	const size_t FILE_COUNT=sizeof(FILES)/sizeof(*FILES);
+	try
+	{
+		std::string corpus;
+		for(size_t file=0;file<FILE_COUNT;file++)
+		{
+			int fd=open(FILES[file],O_RDONLY);
+			if(fd<0) return -10;
+			uint8_t data[4096];
+			int len=read(fd,data,sizeof(data));
+			close(fd);
+			iox p=iox::parse_binary(data,len);
+			x.reset_construct_text();
+			if(file<NITS)
+			{
+				struct network_information_section T={0};
+				T.io(p);
+				T.io(x);
+			}
+			else
+			{
+				struct event_information_section T={0};
+				T.io(p);
+				T.io(x);
+			}
+			corpus+=ctx->prod;
+		}
+		std::vector<test_text_op> ops;
+		if(!test_text_ops(corpus,ops)) return -11;
+		//best of interleaved repetitions, so both sides see same load
+		const int ROUNDS=20;
+		double t=1e9,t_ref=1e9;
+		for(int rep=0;rep<15;rep++)
+		{
+			double ta=0,tb=0;
+			std::string a,b;
+			for(int k=0;k<ROUNDS;k++)
+			{
+				ta+=test_text_replay(x,ops,a);
+				tb+=test_text_replay_reference(ops,b);
+			}
+			if(a!=corpus) return -12;
+			if(b!=corpus) return -13;
+			t=std::min(t,ta);
+			t_ref=std::min(t_ref,tb);
+		}
+		printf("NIT and EIT corpus to text %d times: table %.3f ms, reference %.3f ms, speedup %.2f, %.1f MB/s of text\n",
+				ROUNDS,t*1e3,t_ref*1e3,t_ref/t,corpus.size()*ROUNDS/t/1e6);
+		if(t_ref<3*t) return -14;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -15;
+	}
+	return 0;
+}
+
+DEFTEST(test_text_parse_large,"test parsing multi-megabyte text of given length");
+MAKEDEP(test_text_parse_large,test_nit_table_parsing_1);
+int test_text_parse_large()
+{
+	const char* FILES[]={
+			"tests/data/Bromley_NIT.sec",
+			"tests/data/BBC_NIT.sec",
+			"tests/data/MUX1_NIT.sec",
+			"tests/data/MUX3_NIT.sec"};
+	const int N=sizeof(FILES)/sizeof(*FILES);
+	std::vector<network_information_section> nits(N);
+	std::string texts[N];
+	for(int file=0;file<N;file++)
+	{
+		int fd;
+		fd=open(FILES[file],O_RDONLY);
+		if(fd<0) return -10000*file-1;
+		uint8_t data[2000];
+		int r;
+		r=read(fd,data,2000);
+		close(fd);
+		try
+		{
+			iox x=iox::parse_binary(data,r);
+			nits[file].io(x);
+			iox t=iox::construct_text();
+			nits[file].io(t);
+			texts[file]=t.as_ocx().ctx->prod;
+		}
+		catch(const Exception& e)
+		{
+			printf("%s\n",e.message.c_str());
+			return -10000*file-2;
+		}
+	}
+	//represents more than 1MB of binary, copied to buffer without terminating 0
+	std::string all;
+	uint32_t count=0;
+	while(all.size()<12*1000000)
+	{
+		all+=texts[count%N];
+		count++;
+	}
+	char* buf=(char*)malloc(all.size());
+	if(buf==NULL) return -1;
+	memcpy(buf,all.data(),all.size());
+	int res=0;
+	iox y=iox::parse_text(buf,all.size());
+	try
+	{
+		uint32_t lines=1;
+		for(uint32_t i=0;i<count;i++)
+		{
+			network_information_section T={0};
+			T.io(y);
+			iox t=iox::construct_text();
+			T.io(t);
+			if(t.as_ocx().ctx->prod!=texts[i%N]) {res=-2;goto out;}
+			for(size_t j=0;j<texts[i%N].size();j++)
+				if(texts[i%N][j]=='\n') lines++;
+			//whitespace after last section is consumed on next one
+			if(i+1<count && y.as_icx().ctx->line_nr+1!=lines) {res=-3;goto out;}
+		}
+		if(y.as_icx().ctx->skiptotoken()) {res=-4;goto out;}
+		if(y.ctx->bitpos<=8*1000000) {res=-5;goto out;}
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		res=-6;
+		goto out;
+	}
+	//error in last section is reported with its line and column
+	{
+		size_t last=all.size()-texts[(count-1)%N].size();
+		const char* p=(const char*)memmem(buf+last,all.size()-last,"network_id:",11);
+		if(p==NULL) {res=-7;goto out;}
+		p+=11;
+		uint32_t line=1;
+		const char* line_begin=buf;
+		for(const char* q=buf;q<p;q++)
+			if(*q=='\n')
+			{
+				line++;
+				line_begin=q+1;
+			}
+		buf[p-buf]='x';
+		char where[40];
+		sprintf(where,"<input>:%u:%ld ",line,(long)(p-line_begin));
+		y.reset(buf,all.size());
+		try
+		{
+			for(uint32_t i=0;i<count;i++)
+			{
+				network_information_section T={0};
+				T.io(y);
+			}
+			res=-8;
+			goto out;
+		}
+		catch(const Exception& e)
+		{
+			if(e.message.find(where)==std::string::npos)
+			{
+				printf("%s\n",e.message.c_str());
+				res=-9;
+				goto out;
+			}
+		}
+	}
+	//digits beyond 19 decimal, 16 hexadecimal and 64 binary are still checked for overflow
+	try
+	{
+		uint64_t v;
+		y.reset("v:18446744073709551615 v:0xffffffffffffffff",43);
+		y.uint(64,DVB_VAR(v));
+		if(v!=UINT64_MAX) {res=-10;goto out;}
+		y.uint(64,DVB_VAR(v));
+		if(v!=UINT64_MAX) {res=-11;goto out;}
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		res=-12;
+		goto out;
+	}
+	{
+		const char* over[3]={"v:18446744073709551616","v:0x10000000000000000",
+				"v:0b10000000000000000000000000000000000000000000000000000000000000000"};
+		for(int i=0;i<3;i++)
+		{
+			try
+			{
+				uint64_t v;
+				y.reset(over[i],strlen(over[i]));
+				y.uint(64,DVB_VAR(v));
+				res=-13-i;
+				goto out;
+			}
+			catch(const Exception& e)
+			{
+			}
+		}
+	}
+	out:
+	free(buf);
+	return res;
+}
+
+DEFTEST(test_crc32_slicing,"test slicing CRC32 against single table, slice16 faster than slice8 on 1024 and 4096 bytes");
+int test_crc32_slicing()
+{
+	std::vector<uint8_t> data(4096+16);
+	uint64_t seed=0x0123456789abcdefULL;
+	for(size_t i=0;i<data.size();i++)
+	{
+		seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+		data[i]=seed>>56;
+	}
+	for(int len=0;len<=4096;len++)
+	{
+		int offset=len%16;
+		uint32_t ref=dvb_crc32_bytewise(&data[offset],len);
+		if(dvb_crc32_slice8(&data[offset],len)!=ref) return -1;
+		if(dvb_crc32_slice16(&data[offset],len)!=ref) return -2;
+		if(dvb_crc32(&data[offset],len)!=ref) return -3;
+	}
+	//section followed by its CRC gives 0
+	for(int len=0;len<=64;len++)
+	{
+		uint8_t buf[68];
+		memcpy(buf,&data[0],len);
+		uint32_t crc=dvb_crc32(buf,len);
+		buf[len]=crc>>24;
+		buf[len+1]=crc>>16;
+		buf[len+2]=crc>>8;
+		buf[len+3]=crc;
+		if(dvb_crc32_bytewise(buf,len+4)!=0) return -4;
+		if(dvb_crc32(buf,len+4)!=0) return -5;
+	}
+
+	const int sizes[2]={1024,4096};
+	uint32_t (*impl[3])(const uint8_t*,int)={dvb_crc32_bytewise,dvb_crc32_slice8,dvb_crc32_slice16};
+	const char* names[3]={"bytewise","slice8","slice16"};
+	for(int s=0;s<2;s++)
+	{
+		const int N=1024*1024/sizes[s];
+		//best of interleaved repetitions, so all variants see same load
+		double best[3]={1e9,1e9,1e9};
+		for(int rep=0;rep<5;rep++)
+			for(int i=0;i<3;i++)
+			{
+				uint32_t x=0;
+				double t0=test_now();
+				for(int k=0;k<N;k++)
+					x^=impl[i](&data[0],sizes[s]);
+				double t1=test_now();
+				if(x!=(N&1?impl[0](&data[0],sizes[s]):0)) return -6;
+				best[i]=std::min(best[i],t1-t0);
+			}
+		printf("crc32 of %d byte sections:",sizes[s]);
+		for(int i=0;i<3;i++)
+			printf(" %s %.1f MB/s",names[i],(double)N*sizes[s]/best[i]/1e6);
+		printf("\n");
+		//MOPA_CRC_SLICES defaults to 16 only because it is faster than 8
+		if(best[1]>=best[0]) return -7;
+		if(best[2]>=best[1]) return -8;
+	}
+	return 0;
+}
+
+DEFTEST(test_crc32_clmul,"test carry-less multiplication CRC32 on random lengths, faster than slice16");
+MAKEDEP(test_crc32_clmul,test_crc32_slicing);
+int test_crc32_clmul()
+{
+#if MOPA_CRC_CLMUL
+	if(!dvb_crc32_clmul_supported())
+	{
+		printf("PCLMULQDQ not supported, skipped\n");
+		return 0;
+	}
+	std::vector<uint8_t> data(4096+16);
+	uint64_t seed=0xfedcba9876543210ULL;
+	for(size_t i=0;i<data.size();i++)
+	{
+		seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+		data[i]=seed>>56;
+	}
+	for(int len=0;len<=4096;len++)
+	{
+		int offset=len%16;
+		if(dvb_crc32_clmul(&data[offset],len)!=dvb_crc32_bytewise(&data[offset],len)) return -1;
+	}
+	for(int i=0;i<10000;i++)
+	{
+		seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+		int len=(seed>>33)%4097;
+		int offset=(seed>>20)%16;
+		data[(seed>>8)%data.size()]^=1<<(seed%8);
+		if(dvb_crc32_clmul(&data[offset],len)!=dvb_crc32_bytewise(&data[offset],len)) return -2;
+		if(dvb_crc32(&data[offset],len)!=dvb_crc32_bytewise(&data[offset],len)) return -3;
+	}
+	//clmul is selected over slicing only because it is faster
+	const int sizes[2]={1024,4096};
+	uint32_t (*impl[2])(const uint8_t*,int)={dvb_crc32_slice16,dvb_crc32_clmul};
+	for(int s=0;s<2;s++)
+	{
+		const int N=1024*1024/sizes[s];
+		double best[2]={1e9,1e9};
+		for(int rep=0;rep<5;rep++)
+			for(int i=0;i<2;i++)
+			{
+				uint32_t x=0;
+				double t0=test_now();
+				for(int k=0;k<N;k++)
+					x^=impl[i](&data[0],sizes[s]);
+				double t1=test_now();
+				if(x!=0) return -4;
+				best[i]=std::min(best[i],t1-t0);
+			}
+		printf("crc32 of %d byte sections: slice16 %.1f MB/s clmul %.1f MB/s\n",sizes[s],
+				(double)N*sizes[s]/best[0]/1e6,(double)N*sizes[s]/best[1]/1e6);
+		if(best[1]>=best[0]) return -5;
+	}
+#endif
+	return 0;
+}
+
+DEFTEST(test_psi_extractor_crc,"test CRC check of sections in psi_extractor");
+MAKEDEP(test_psi_extractor_crc,test_crc32_slicing);
+static void test_collect_packet(void* ctx,const uint8_t* packet)
+{
+	std::vector<uint8_t>* ts=(std::vector<uint8_t>*)ctx;
+	ts->insert(ts->end(),packet,packet+188);
+}
+struct test_crc_sections
+{
+	uint32_t count;
+	uint32_t bad;
+	uint32_t mismatch;
+};
+static void test_on_section_crc(void* ctx,const uint8_t* section,size_t len,bool crc_ok)
+{
+	test_crc_sections* r=(test_crc_sections*)ctx;
+	r->count++;
+	if(!crc_ok) r->bad++;
+	if(crc_ok!=(dvb_crc32(section,len)==0)) r->mismatch++;
+}
+static void test_on_section_count(void* ctx,const uint8_t* section,size_t len)
+{
+	test_crc_sections* r=(test_crc_sections*)ctx;
+	r->count++;
+	if(dvb_crc32(section,len)!=0) r->bad++;
+}
+int test_psi_extractor_crc()
+{
+	const char* FILES[]={
+			"tests/data/BBC_NIT.sec",
+			"tests/data/BBC_PAT.sec",
+			"tests/data/BBC_SDT.sec",
+			"tests/data/BBC_TOT.sec",
+			"tests/data/Bromley_CAT.sec",
+			"tests/data/Bromley_EIT.sec",
+			"tests/data/Bromley_SDT.sec",
+			"tests/data/MUX1_EIT.sec",
+			"tests/data/MUX3_EIT.sec"};
+	std::vector<uint8_t> ts;
+	sec2ts* s=sec2ts::create();
+	s->setPID(0x12);
+	s->on_ts_packet_produced(&ts,test_collect_packet);
+	uint32_t sections=0;
+	//each section several times, so that damage below hits various positions
+	for(int n=0;n<20*(int)(sizeof(FILES)/sizeof(*FILES));n++)
+	{
+		int file=n%(sizeof(FILES)/sizeof(*FILES));
+		int fd;
+		fd=open(FILES[file],O_RDONLY);
+		if(fd<0) return -10000*file-1;
+		uint8_t data[8192];
+		int r;
+		r=read(fd,data,sizeof(data));
+		close(fd);
+		for(int pos=0;pos+3<=r;)
+		{
+			int len=3+((data[pos+1]<<8|data[pos+2])&0xfff);
+			if(pos+len>r) return -10000*file-2;
+			if(dvb_crc32(data+pos,len)!=0) return -10000*file-3;
+			s->section(data+pos,len);
+			sections++;
+			pos+=len;
+		}
+	}
+	s->flush();
+	delete s;
+
+	test_crc_sections res={0};
+	psi_extractor* p=psi_extractor::create(4096,0);
+	p->set_crc_check(psi_extractor::crc_report);
+	p->on_section_ready(&res,test_on_section_crc);
+	for(size_t i=0;i<ts.size();i+=188)
+		p->ts_packet(&ts[i]);
+	if(res.count!=sections) return -1;
+	if(res.bad!=0 || res.mismatch!=0) return -2;
+
+	//damage one byte in each of a few packets, sections that contain them get bad CRC
+	for(size_t i=188*3;i<ts.size();i+=188*17)
+		ts[i+100]^=0x10;
+	res=test_crc_sections{0};
+	p->set_crc_check(psi_extractor::crc_none);
+	p->on_section_ready(&res,test_on_section_count);
+	for(size_t i=0;i<ts.size();i+=188)
+		p->ts_packet(&ts[i]);
+	uint32_t count=res.count;
+	uint32_t bad=res.bad;
+	if(bad==0) return -3;
+
+	res=test_crc_sections{0};
+	p->set_crc_check(psi_extractor::crc_report);
+	p->on_section_ready(&res,test_on_section_crc);
+	for(size_t i=0;i<ts.size();i+=188)
+		p->ts_packet(&ts[i]);
+	if(res.count!=count) return -4;
+	if(res.bad!=bad || res.mismatch!=0) return -5;
+
+	res=test_crc_sections{0};
+	p->set_crc_check(psi_extractor::crc_drop);
+	p->on_section_ready(&res,test_on_section_count);
+	for(size_t i=0;i<ts.size();i+=188)
+		p->ts_packet(&ts[i]);
+	if(res.count!=count-bad) return -6;
+	if(res.bad!=0) return -7;
+	delete p;
+	return 0;
+}
+
+DEFTEST(test_crc32_combine_patch,"test combining CRC32 of chunks and patching CRC32 of modified data");
+MAKEDEP(test_crc32_combine_patch,test_crc32_slicing);
+int test_crc32_combine_patch()
+{
+	std::vector<uint8_t> data(4096);
+	uint64_t seed=0x5555aaaa3333ccccULL;
+	for(size_t i=0;i<data.size();i++)
+	{
+		seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+		data[i]=seed>>56;
+	}
+	for(int i=0;i<1000;i++)
+	{
+		seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+		int len=(seed>>33)%4097;
+		int split=len==0?0:(seed>>8)%(len+1);
+		uint32_t a=dvb_crc32(&data[0],split);
+		uint32_t b=dvb_crc32(&data[split],len-split);
+		if(dvb_crc32_combine(a,b,len-split)!=dvb_crc32(&data[0],len)) return -1;
+	}
+	//chunks calculated independently
+	{
+		uint32_t crc=dvb_crc32(&data[0],1000);
+		for(int pos=1000;pos<4096;pos+=1000)
+		{
+			int len=pos+1000<=4096?1000:4096-pos;
+			crc=dvb_crc32_combine(crc,dvb_crc32(&data[pos],len),len);
+		}
+		if(crc!=dvb_crc32(&data[0],4096)) return -2;
+	}
+	for(int i=0;i<1000;i++)
+	{
+		seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+		int len=1+(seed>>33)%4096;
+		int offset=(seed>>8)%len;
+		int delta_len=1+(seed>>50)%(len-offset<8?len-offset:8);
+		uint8_t delta[8];
+		uint32_t crc=dvb_crc32(&data[0],len);
+		for(int j=0;j<delta_len;j++)
+		{
+			delta[j]=(seed>>(8*j))|1;
+			data[offset+j]^=delta[j];
+		}
+		if(dvb_crc32_patch(crc,len,offset,delta,delta_len)!=dvb_crc32(&data[0],len)) return -3;
+	}
+
+	//bump version_number of constructed NIT and fix CRC_32 in place
+	int fd;
+	fd=open("tests/data/MUX1_NIT.sec",O_RDONLY);
+	if(fd<0) return -4;
+	uint8_t section[1024];
+	int r;
+	r=read(fd,section,sizeof(section));
+	close(fd);
+	try
+	{
+		struct network_information_section T={0};
+		iox x=iox::parse_binary(section,r);
+		T.io(x);
+		T.version_number=(T.version_number+1)&0x1f;
+		uint8_t out[1024];
+		iox y=iox::construct_binary(out,sizeof(out));
+		T.io(y);
+		uint32_t len=y.ctx->bitpos/8;
+		if(len!=(uint32_t)r) return -5;
+		uint8_t delta[1]={(uint8_t)(section[5]^out[5])};
+		uint32_t crc=section[r-4]<<24|section[r-3]<<16|section[r-2]<<8|section[r-1];
+		crc=dvb_crc32_patch(crc,r-4,5,delta,1);
+		section[5]^=delta[0];
+		section[r-4]=crc>>24;
+		section[r-3]=crc>>16;
+		section[r-2]=crc>>8;
+		section[r-1]=crc;
+		if(memcmp(section,out,r)!=0) return -6;
+	}
+	catch(const Exception& e)
+	{
+		printf("%s\n",e.message.c_str());
+		return -7;
+	}
+	return 0;
+}
+
+DEFTEST(test_psi_demux,"test extraction of sections of many PIDs from mux");
+MAKEDEP(test_psi_demux,test_psi_extractor_crc);
+struct test_demux_sections
+{
+	uint32_t count[8192];
+	uint32_t bad;
+};
+static void test_on_demux_section(void* ctx,uint16_t pid,const uint8_t* section,size_t len,bool crc_ok)
+{
+	test_demux_sections* r=(test_demux_sections*)ctx;
+	r->count[pid]++;
+	if(!crc_ok || dvb_crc32(section,len)!=0) r->bad++;
+}
+int test_psi_demux()
+{
+	struct
+	{
+		const char* file;
+		uint16_t pid;
+	} streams[]={
+			{"tests/data/MUX1_PAT.sec",0x00},
+			{"tests/data/Bromley_CAT.sec",0x01},
+			{"tests/data/MUX1_NIT.sec",0x10},
+			{"tests/data/MUX1_SDT.sec",0x11},
+			{"tests/data/MUX1_EIT.sec",0x12},
+			{"tests/data/MUX1_TOT.sec",0x14},
+			{"tests/data/MUX1_SDT.sec",0x12d}, //first PMT PID of MUX1_PAT, stands for PMT
+			{"tests/data/MUX3_NIT.sec",0x200}}; //PID not selected
+	const int S=sizeof(streams)/sizeof(*streams);
+	const int REPEAT=50;
+	std::vector<uint8_t> packets[S];
+	for(int i=0;i<S;i++)
+	{
+		int fd;
+		fd=open(streams[i].file,O_RDONLY);
+		if(fd<0) return -100*i-1;
+		uint8_t data[4096];
+		int r;
+		r=read(fd,data,sizeof(data));
+		close(fd);
+		sec2ts* s=sec2ts::create();
+		s->setPID(streams[i].pid);
+		s->on_ts_packet_produced(&packets[i],test_collect_packet);
+		for(int k=0;k<REPEAT;k++)
+			s->section(data,r);
+		s->flush();
+		delete s;
+	}
+	//interleave, with video packets in between
+	std::vector<uint8_t> mux;
+	uint8_t video[188];
+	memset(video,0x47,sizeof(video));
+	video[1]=0x01;
+	video[2]=0x00;
+	video[3]=0x10;
+	size_t pos[S]={0};
+	bool more;
+	do
+	{
+		more=false;
+		for(int i=0;i<S;i++)
+		{
+			if(pos[i]<packets[i].size())
+			{
+				mux.insert(mux.end(),&packets[i][pos[i]],&packets[i][pos[i]]+188);
+				pos[i]+=188;
+				more=true;
+			}
+			for(int k=0;k<4;k++)
+			{
+				video[3]=0x10|((video[3]+1)&0xf);
+				mux.insert(mux.end(),video,video+188);
+			}
+		}
+	}
+	while(more);
+
+	test_demux_sections* res=new test_demux_sections;
+	int result=0;
+	psi_demux* d=psi_demux::create();
+	d->on_section_ready(res,test_on_demux_section);
+	d->set_crc_check(psi_extractor::crc_report);
+	for(int follow=0;follow<2;follow++)
+	{
+		memset(res,0,sizeof(*res));
+		d->set_follow_pat(follow);
+		for(size_t i=0;i<mux.size();i+=188)
+			d->ts_packet(&mux[i]);
+		for(int i=0;i<S;i++)
+		{
+			uint32_t expected=REPEAT;
+			if(streams[i].pid==0x12d) expected=follow?REPEAT:0;
+			if(streams[i].pid==0x200) expected=0;
+			if(res->count[streams[i].pid]!=expected) {result=-1-i;goto out;}
+		}
+		if(res->count[0x100]!=0) {result=-20;goto out;}
+		if(res->bad!=0) {result=-21;goto out;}
+	}
+	if(!d->has_pid(0x12d) || !d->has_pid(0x191) || d->has_pid(0x200)) {result=-22;goto out;}
+	d->remove_pid(0x12d);
+	if(d->has_pid(0x12d)) {result=-23;goto out;}
+	d->set_follow_pat(false);
+
+	//throughput
+	{
+		double t0=test_now();
+		for(int k=0;k<20;k++)
+			for(size_t i=0;i<mux.size();i+=188)
+				d->ts_packet(&mux[i]);
+		double t1=test_now();
+		printf("demux %zu packets: %.1f Mbit/s\n",20*mux.size()/188,20*mux.size()*8/(t1-t0)/1e6);
+	}
+	out:
+	delete d;
+	delete res;
+	return result;
+}
+
+DEFTEST(test_psi_demux_pat_versions,"test PMT PIDs follow PAT versions and corrupted PAT is ignored");
+MAKEDEP(test_psi_demux_pat_versions,test_psi_demux);
+/**
+ * Sends PAT section with programs {number,PID} to demux as TS packets of PID 0.
+ */
+static void test_send_pat(psi_demux* d,sec2ts* s,int version,int section_number,int last_section_number,
+		const uint16_t (*programs)[2],int n,bool corrupt=false)
+{
+	uint8_t sec[1024];
+	int len=8+4*n+4;
+	sec[0]=0x00;
+	sec[1]=0xb0|((len-3)>>8);
+	sec[2]=(len-3)&0xff;
+	sec[3]=0x10;
+	sec[4]=0x01;
+	sec[5]=0xc1|(version<<1);
+	sec[6]=section_number;
+	sec[7]=last_section_number;
+	for(int i=0;i<n;i++)
+	{
+		sec[8+4*i]=programs[i][0]>>8;
+		sec[9+4*i]=programs[i][0]&0xff;
+		sec[10+4*i]=0xe0|(programs[i][1]>>8);
+		sec[11+4*i]=programs[i][1]&0xff;
+	}
+	uint32_t crc=dvb_crc32(sec,len-4);
+	if(corrupt) crc^=1;
+	for(int i=0;i<4;i++)
+		sec[len-4+i]=crc>>(24-8*i);
+	std::vector<uint8_t> ts;
+	s->on_ts_packet_produced(&ts,test_collect_packet);
+	s->section(sec,len);
+	s->flush();
+	for(size_t i=0;i<ts.size();i+=188)
+		d->ts_packet(&ts[i]);
+}
+int test_psi_demux_pat_versions()
+{
+	psi_demux* d=psi_demux::create();
+	sec2ts* s=sec2ts::create();
+	s->setPID(0);
+	d->set_follow_pat(true);
+	int result=0;
+	const uint16_t v1[][2]={{0,0x10},{1,0x100},{2,0x101},{3,0x102}};
+	const uint16_t bad[][2]={{1,0x300}};
+	const uint16_t v2[][2]={{1,0x100}};
+	const uint16_t v3[][2]={{5,0x105}};
+	d->add_pid(0x102);
+	test_send_pat(d,s,1,0,0,v1,4);
+	if(!d->has_pid(0x100) || !d->has_pid(0x101) || !d->has_pid(0x102)) {result=-1;goto out;}
+	//CRC is not checked by demux, but PAT is still verified
+	test_send_pat(d,s,2,0,0,bad,1,true);
+	if(d->has_pid(0x300) || !d->has_pid(0x101)) {result=-2;goto out;}
+	test_send_pat(d,s,2,0,0,v2,1);
+	if(!d->has_pid(0x100) || d->has_pid(0x101)) {result=-3;goto out;}
+	if(!d->has_pid(0x102) || !d->has_pid(0x10)) {result=-4;goto out;}
+	//PIDs are dropped only when all sections of version are received
+	test_send_pat(d,s,3,0,1,v3,1);
+	if(!d->has_pid(0x100) || !d->has_pid(0x105)) {result=-5;goto out;}
+	test_send_pat(d,s,3,1,1,NULL,0);
+	if(d->has_pid(0x100) || !d->has_pid(0x105)) {result=-6;goto out;}
+	//same version again changes nothing
+	d->add_pid(0x100);
+	test_send_pat(d,s,3,0,1,v3,1);
+	test_send_pat(d,s,3,1,1,NULL,0);
+	if(!d->has_pid(0x100) || !d->has_pid(0x105)) {result=-7;goto out;}
+	out:
+	delete s;
+	delete d;
+	return result;
+}
+
+DEFTEST(test_ts_packets_batch,"test batch packet interfaces of sec2ts, psi_extractor and psi_demux");
+MAKEDEP(test_ts_packets_batch,test_psi_demux);
+struct test_batches
+{
+	std::vector<uint8_t> ts;
+	size_t calls;
+	size_t max;
+};
+static void test_collect_packets(void* ctx,const uint8_t* packets,size_t n)
+{
+	test_batches* b=(test_batches*)ctx;
+	b->ts.insert(b->ts.end(),packets,packets+n*188);
+	b->calls++;
+	if(n>b->max) b->max=n;
+}
+int test_ts_packets_batch()
+{
+	const char* FILES[]={
+			"tests/data/BBC_NIT.sec",
+			"tests/data/BBC_TOT.sec",
+			"tests/data/Bromley_EIT.sec",
+			"tests/data/MUX1_EIT.sec",
+			"tests/data/MUX3_SDT.sec"};
+	const int N=sizeof(FILES)/sizeof(*FILES);
+	std::vector<uint8_t> sections[N];
+	for(int file=0;file<N;file++)
+	{
+		int fd;
+		fd=open(FILES[file],O_RDONLY);
+		if(fd<0) return -100*file-1;
+		uint8_t data[4096];
+		int r;
+		r=read(fd,data,sizeof(data));
+		close(fd);
+		sections[file].assign(data,data+r);
+	}
+	std::vector<uint8_t> ts;
+	test_batches b={std::vector<uint8_t>(),0,0};
+	sec2ts* s1=sec2ts::create();
+	sec2ts* s2=sec2ts::create();
+	s1->setPID(0x12);
+	s2->setPID(0x12);
+	s1->on_ts_packet_produced(&ts,test_collect_packet);
+	s2->on_ts_packets_produced(&b,test_collect_packets,7);
+	for(int k=0;k<200;k++)
+	{
+		s1->section(&sections[k%N][0],sections[k%N].size());
+		s2->section(&sections[k%N][0],sections[k%N].size());
+		if(k==100)
+		{
+			//switching in the middle of packet
+			s2->on_ts_packets_produced(&b,test_collect_packets,16);
+		}
+	}
+	s1->flush();
+	s2->flush();
+	delete s1;
+	delete s2;
+	if(b.ts!=ts) return -1;
+	if(b.max!=16 || b.calls>ts.size()/188/7+3) return -2;
+
+	test_crc_sections r1={0},r2={0};
+	psi_extractor* p1=psi_extractor::create(4096,0);
+	psi_extractor* p2=psi_extractor::create(4096,0);
+	p1->set_crc_check(psi_extractor::crc_report);
+	p2->set_crc_check(psi_extractor::crc_report);
+	p1->on_section_ready(&r1,test_on_section_crc);
+	p2->on_section_ready(&r2,test_on_section_crc);
+	for(size_t i=0;i<ts.size();i+=188)
+		p1->ts_packet(&ts[i]);
+	for(size_t i=0;i<ts.size();i+=188*13)
+		p2->ts_packets(&ts[i],std::min<size_t>(13,(ts.size()-i)/188));
+	delete p1;
+	delete p2;
+	if(r1.count!=200 || r2.count!=200) return -3;
+	if(r1.bad!=0 || r2.bad!=0) return -4;
+
+	//mux of section PIDs only, in runs of 4 packets, to compare cost of packet dispatch
+	std::vector<uint8_t> mux;
+	const uint16_t PIDS[]={0x00,0x01,0x10,0x11,0x12,0x14};
+	for(size_t i=0;i<ts.size();i+=188*4)
+		for(size_t k=0;k<sizeof(PIDS)/sizeof(*PIDS);k++)
+			for(size_t j=i;j<i+188*4 && j<ts.size();j+=188)
+			{
+				uint8_t packet[188];
+				memcpy(packet,&ts[j],188);
+				packet[1]=(packet[1]&0xe0)|(PIDS[k]>>8);
+				packet[2]=PIDS[k];
+				mux.insert(mux.end(),packet,packet+188);
+			}
+	test_demux_sections* res1=new test_demux_sections;
+	test_demux_sections* res2=new test_demux_sections;
+	memset(res1,0,sizeof(*res1));
+	memset(res2,0,sizeof(*res2));
+	psi_demux* d1=psi_demux::create();
+	psi_demux* d2=psi_demux::create();
+	d1->on_section_ready(res1,test_on_demux_section);
+	d2->on_section_ready(res2,test_on_demux_section);
+	const int R=20;
+	double t0=test_now();
+	for(int k=0;k<R;k++)
+		for(size_t i=0;i<mux.size();i+=188)
+			d1->ts_packet(&mux[i]);
+	double t1=test_now();
+	for(int k=0;k<R;k++)
+		for(size_t i=0;i<mux.size();i+=188*64)
+			d2->ts_packets(&mux[i],std::min<size_t>(64,(mux.size()-i)/188));
+	double t2=test_now();
+	printf("demux %zu packets: single %.1f Mbit/s, batch %.1f Mbit/s\n",R*mux.size()/188,
+			R*mux.size()*8/(t1-t0)/1e6,R*mux.size()*8/(t2-t1)/1e6);
+	int result=0;
+	if(memcmp(res1,res2,sizeof(*res1))!=0) result=-5;
+	if(res1->count[0x00]!=R*200 || res1->count[0x14]!=R*200 || res1->bad!=0) result=-6;
+	delete d1;
+	delete d2;
+	delete res1;
+	delete res2;
+	return result;
+}
+
+DEFTEST(test_ts_framer,"test detection of packet size and resynchronization");
+MAKEDEP(test_ts_framer,test_ts_packets_batch);
+struct test_framed
+{
+	std::vector<uint8_t> packets;
+	psi_extractor* extractor;
+};
+static void test_on_framed(void* ctx,const uint8_t* packets,size_t n,size_t stride)
+{
+	test_framed* f=(test_framed*)ctx;
+	for(size_t i=0;i<n;i++)
+		f->packets.insert(f->packets.end(),packets+i*stride,packets+i*stride+188);
+	f->extractor->ts_packets(packets,n,stride);
+}
+int test_ts_framer()
+{
+	const char* FILES[]={
+			"tests/data/BBC_NIT.sec",
+			"tests/data/Bromley_SDT.sec",
+			"tests/data/MUX1_EIT.sec",
+			"tests/data/MUX3_TOT.sec"};
+	const int N=sizeof(FILES)/sizeof(*FILES);
+	std::vector<uint8_t> ts;
+	sec2ts* s=sec2ts::create();
+	s->setPID(0x11);
+	s->on_ts_packet_produced(&ts,test_collect_packet);
+	const int SECTIONS=100;
+	for(int k=0;k<SECTIONS;k++)
+	{
+		int fd;
+		fd=open(FILES[k%N],O_RDONLY);
+		if(fd<0) return -1;
+		uint8_t data[4096];
+		int r;
+		r=read(fd,data,sizeof(data));
+		close(fd);
+		s->section(data,r);
+	}
+	s->flush();
+	delete s;
+	size_t count=ts.size()/188;
+	uint64_t seed=0x1234567887654321ULL;
+	const size_t strides[3]={188,192,204};
+	for(int st=0;st<3;st++)
+	for(int damage=0;damage<2;damage++)
+	{
+		//garbage, then packets with timestamp or parity bytes
+		std::vector<uint8_t> input;
+		for(int i=0;i<1000;i++)
+			input.push_back(i%0x47);
+		size_t start=input.size();
+		for(size_t i=0;i<count;i++)
+		{
+			if(strides[st]==192)
+				input.insert(input.end(),4,i%0x47);
+			input.insert(input.end(),&ts[i*188],&ts[i*188]+188);
+			if(strides[st]==204)
+				input.insert(input.end(),16,i%0x47);
+		}
+		size_t damaged=count/2;
+		if(damage)
+			input[start+damaged*strides[st]+(strides[st]==192?4:0)]=0x48;
+
+		test_framed f;
+		test_crc_sections res={0};
+		f.extractor=psi_extractor::create(4096,0);
+		f.extractor->set_crc_check(psi_extractor::crc_report);
+		f.extractor->on_section_ready(&res,test_on_section_crc);
+		ts_framer* fr=ts_framer::create();
+		fr->on_packets_ready(&f,test_on_framed);
+		for(size_t pos=0;pos<input.size();)
+		{
+			seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+			size_t len=1+(seed>>33)%(seed&1?300:5000);
+			if(len>input.size()-pos) len=input.size()-pos;
+			fr->data(&input[pos],len);
+			pos+=len;
+		}
+		int result=0;
+		std::vector<uint8_t> expected(ts);
+		if(damage)
+			expected.erase(expected.begin()+damaged*188,expected.begin()+(damaged+1)*188);
+		if(fr->packet_size()!=strides[st]) result=-2;
+		else if(fr->sync_losses()!=(uint32_t)damage) result=-3;
+		else if(f.packets!=expected) result=-4;
+		else if(res.count!=(damage?SECTIONS-1:SECTIONS) || res.bad!=0 || res.mismatch!=0) result=-5;
+		delete fr;
+		delete f.extractor;
+		if(result!=0) return result-10*st-100*damage;
+	}
+	return 0;
+}
+
+DEFTEST(test_nit_table_parsing_2,"test parsing of example NIT table with error injections");
+MAKEDEP(test_nit_table_parsing_2,test_nit_table_parsing_1);
+int test_nit_table_parsing_2()
+{
+	for(int iter=0;iter<100;iter++)
+	{
+		int fd;
 		fd=open("tests/data/Bromley_NIT.sec",O_RDONLY);
 		if(fd<0) return -1;
 		uint8_t data[2000];
-		uint8_t out[2000];
 		int r;
 		r=read(fd,data,2000);
 		close(fd);
@@ -1278,7 +3856,6 @@ int test_nit_table_parsing_3()
 		fd=open("tests/data/Bromley_NIT.sec",O_RDONLY);
 		if(fd<0) return -1;
 		uint8_t data[2000];
-		uint8_t out[2000];
 		int r;
 		r=read(fd,data,2000);
 		close(fd);
@@ -1313,6 +3890,79 @@ int test_nit_table_parsing_3()
 	return 0;
 }
 
+DEFTEST(test_nit_table_try_io_speed,"test rejecting bit changed NIT table is faster with try_io than with exceptions");
+MAKEDEP(test_nit_table_try_io_speed,test_nit_table_parsing_3,test_nit_table_try_io);
+int test_nit_table_try_io_speed()
+{
+	int fd;
+	fd=open("tests/data/Bromley_NIT.sec",O_RDONLY);
+	if(fd<0) return -1;
+	uint8_t data[2000];
+	int r;
+	r=read(fd,data,2000);
+	close(fd);
+	if(r!=715) return -2;
+	//same input as test_nit_table_parsing_3, every single bit change
+	iox x;
+	double best[3]={1e9,1e9,1e9};
+	int rejected=0;
+	for(int rep=0;rep<5;rep++)
+	{
+		int count[2]={0,0};
+		double t0=test_now();
+		for(int iter=0;iter<r*8;iter++)
+		{
+			data[iter/8]^=1<<(iter&7);
+			struct network_information_section T={0};
+			try
+			{
+				x.reset(data,r);
+				T.io(x);
+			}
+			catch(const Exception& e)
+			{
+				count[0]++;
+			}
+			data[iter/8]^=1<<(iter&7);
+		}
+		double t1=test_now();
+		for(int iter=0;iter<r*8;iter++)
+		{
+			data[iter/8]^=1<<(iter&7);
+			struct network_information_section T={0};
+			io_error err;
+			x.reset(data,r);
+			if(!try_io(x,T,&err))
+				count[1]++;
+			data[iter/8]^=1<<(iter&7);
+		}
+		double t2=test_now();
+		size_t length=0;
+		for(int iter=0;iter<r*8;iter++)
+		{
+			data[iter/8]^=1<<(iter&7);
+			struct network_information_section T={0};
+			io_error err;
+			x.reset(data,r);
+			if(!try_io(x,T,&err))
+				length+=err.message().size();
+			data[iter/8]^=1<<(iter&7);
+		}
+		double t3=test_now();
+		if(count[0]!=count[1] || length==0) return -3;
+		rejected=count[1];
+		best[0]=std::min(best[0],t1-t0);
+		best[1]=std::min(best[1],t2-t1);
+		best[2]=std::min(best[2],t3-t2);
+	}
+	printf("%d of %d bit changes rejected: exception %.3f ms, try_io %.3f ms, speedup %.2f, "
+			"try_io with message %.3f ms\n",
+			rejected,r*8,best[0]*1000,best[1]*1000,best[0]/best[1],best[2]*1000);
+	//try_io neither unwinds nor formats
+	if(best[1]>=best[0]) return -4;
+	return 0;
+}
+
 DEFTEST(test_bbc_eit_extract,"test extraction of EIT sections from bbc ts");
 //MAKEDEP(test_bbc_eit_parse,test_nit_table_parsing_2);
 
@@ -1356,6 +4006,7 @@ int main(int argc, char** argv)
 	RUNTEST(test_parse_uint8_t_extensive);
 	RUNTEST(test_parse_uint16_t_extensive);
 	RUNTEST(test_parse_uint32_t_extensive);
+	RUNTEST(test_parse_mixed_widths);
 
 	RUNTEST(test_parse_exception);
 	RUNTEST(test_parse_exception_uint8_t);
@@ -1365,6 +4016,13 @@ int main(int argc, char** argv)
 	RUNTEST(test_basic_construct_uint8_t);
 	RUNTEST(test_basic_construct_uint16_t);
 	RUNTEST(test_basic_construct_uint32_t);
+	RUNTEST(test_construct_mixed_widths);
+	RUNTEST(test_construct_block_backpatch);
+	RUNTEST(test_construct_block_memcpy_payload);
+	RUNTEST(test_uint64_t_binary);
+	RUNTEST(test_uint64_t_text);
+	RUNTEST(test_uint_fixed_width);
+	RUNTEST(test_record_fields);
 
 	RUNTEST(test_block_parsing);
 	RUNTEST(test_block_alignment_on_enter);
@@ -1375,11 +4033,14 @@ int main(int argc, char** argv)
 	RUNTEST(test_text_construct_parse_consistency);
 	RUNTEST(test_construct_block_1);
 	RUNTEST(test_construct_block_2);
+	RUNTEST(test_block_deep_nesting);
+	RUNTEST(test_text_block_lengths);
 	RUNTEST(test_construct_exception_1);
 	RUNTEST(test_construct_exception_2);
 	RUNTEST(test_construct_exception_3);
 	RUNTEST(test_construct_exception_4);
 	RUNTEST(test_construct_exception_5);
+	RUNTEST(test_construct_exception_6);
 
 	RUNTEST(test_short_string_extensive_text);
 	RUNTEST(test_short_string_extensive_bin);
@@ -1387,16 +4048,41 @@ int main(int argc, char** argv)
 	RUNTEST(test_fixed_strings_text);
 	RUNTEST(test_fixed_strings_bin);
 
+	RUNTEST(test_string_ref);
 	RUNTEST(test_string_exception_1);
 	RUNTEST(test_string_exception_2);
 	RUNTEST(test_string_exception_3);
 	RUNTEST(test_string_exception_4);
 	RUNTEST(test_string_exception_5);
 
+	RUNTEST(test_iox_reset_and_move);
 	RUNTEST(test_ts_specification_1);
+	RUNTEST(test_lazy_descriptor_vector);
+	RUNTEST(test_lazy_descriptor_vector_block);
 	RUNTEST(test_nit_table_parsing_1);
+	RUNTEST(test_nit_table_static_modes);
+	RUNTEST(test_nit_table_projection);
+	RUNTEST(test_nit_table_validation);
+	RUNTEST(test_nit_table_measure);
+	RUNTEST(test_nit_table_try_io);
+	RUNTEST(test_nit_table_text_sink);
+	RUNTEST(test_eit_table_parsing_1);
+	RUNTEST(test_eit_table_static_modes);
+	RUNTEST(test_eit_table_measure);
+	RUNTEST(test_eit_table_validation);
+	RUNTEST(test_text_format_speed);
+	RUNTEST(test_text_parse_large);
+	RUNTEST(test_crc32_slicing);
+	RUNTEST(test_crc32_clmul);
+	RUNTEST(test_crc32_combine_patch);
+	RUNTEST(test_psi_extractor_crc);
+	RUNTEST(test_psi_demux);
+	RUNTEST(test_psi_demux_pat_versions);
+	RUNTEST(test_ts_packets_batch);
+	RUNTEST(test_ts_framer);
 	RUNTEST(test_nit_table_parsing_2);
 	RUNTEST(test_nit_table_parsing_3);
+	RUNTEST(test_nit_table_try_io_speed);
 
 	RUNTEST(test_bbc_eit_extract);
 //goto x;